@@ -0,0 +1,231 @@
+"""
+ctypes bindings for the C++ order book pipeline (liborderbook_c, see
+src/orderbook-simulator/orderbook_c.h).
+
+Lets Python generate synthetic books, extract features and build labeled
+sequences in-process. Results come back as numpy arrays that wrap the native
+buffers directly (no copy, no CSV/.bin round trip).
+
+Build the library first:
+    cmake -S src/orderbook-simulator -B src/orderbook-simulator/build
+    cmake --build src/orderbook-simulator/build --target orderbook_c
+
+The library is looked up in $ORDERBOOK_LIB, then the usual build directories.
+
+Example:
+    sim = Simulator(100.0, 0.05, 10, 0.2, seed=7)
+    sim.step(3000)
+    ext = Extractor(window=10)
+    feats = ext.extract(sim.book)          # (T, 32) float64
+    X, y = ext.label(seq_len=10, threshold=1e-6)
+
+Arrays returned by Book.history() / Extractor.extract() own their native memory.
+X and y from Extractor.label() are views into the extractor and are only valid
+until the next label() call; copy them if they must outlive it.
+"""
+
+import ctypes
+import os
+import secrets
+from pathlib import Path
+
+import numpy as np
+
+ROOT = Path(__file__).resolve().parents[2]
+ABI_VERSION = 2
+
+_SEARCH_PATHS = [
+    ROOT / "src" / "orderbook-simulator" / "build" / "liborderbook_c.so",
+    ROOT / "src" / "orderbook-simulator" / "cmake-build-debug" / "liborderbook_c.so",
+    ROOT / "src" / "orderbook-simulator" / "build" / "liborderbook_c.dylib",
+    ROOT / "src" / "orderbook-simulator" / "cmake-build-debug" / "liborderbook_c.dylib",
+]
+
+_DTYPES = {0: np.float64, 1: np.int32}
+
+
+class _Buffer(ctypes.Structure):
+    _fields_ = [
+        ("data", ctypes.c_void_p),
+        ("shape", ctypes.c_int64 * 2),
+        ("ndim", ctypes.c_int32),
+        ("dtype", ctypes.c_int32),
+    ]
+
+
+def _load_library() -> ctypes.CDLL:
+    candidates = [os.environ["ORDERBOOK_LIB"]] if "ORDERBOOK_LIB" in os.environ else []
+    candidates += [str(p) for p in _SEARCH_PATHS if p.exists()]
+    if not candidates:
+        raise FileNotFoundError("liborderbook_c not found; build the orderbook_c target "
+                                "or set ORDERBOOK_LIB")
+    lib = ctypes.CDLL(candidates[0])
+
+    vp, i32, i64, u64, f64 = ctypes.c_void_p, ctypes.c_int32, ctypes.c_int64, ctypes.c_uint64, ctypes.c_double
+    signatures = {
+        "ob_abi_version": (i32, []),
+        "ob_last_error": (ctypes.c_char_p, []),
+        "ob_book_create": (vp, []),
+        "ob_book_destroy": (None, [vp]),
+        "ob_book_update_bid": (None, [vp, f64, f64]),
+        "ob_book_update_ask": (None, [vp, f64, f64]),
+        "ob_book_clear_level": (None, [vp, i32, f64]),
+        "ob_book_apply_updates": (i32, [vp, vp, vp, vp, i64]),
+        "ob_book_mid_price": (f64, [vp]),
+        "ob_book_spread": (f64, [vp]),
+        "ob_book_history_size": (i64, [vp]),
+        "ob_book_history": (vp, [vp]),
+        "ob_simulator_create": (vp, [f64, f64, i32, f64, u64]),
+        "ob_simulator_destroy": (None, [vp]),
+        "ob_simulator_step": (i32, [vp, i64, f64]),
+        "ob_simulator_book": (vp, [vp]),
+        "ob_extractor_create": (vp, [i32, f64]),
+        "ob_extractor_destroy": (None, [vp]),
+        "ob_extractor_extract": (vp, [vp, vp]),
+        "ob_extractor_label": (i64, [vp, i32, f64]),
+        "ob_extractor_sequences": (_Buffer, [vp]),
+        "ob_extractor_labels": (_Buffer, [vp]),
+        "ob_array_buffer": (_Buffer, [vp]),
+        "ob_array_destroy": (None, [vp]),
+    }
+    for name, (restype, argtypes) in signatures.items():
+        fn = getattr(lib, name)
+        fn.restype = restype
+        fn.argtypes = argtypes
+
+    if lib.ob_abi_version() != ABI_VERSION:
+        raise RuntimeError(f"liborderbook_c ABI {lib.ob_abi_version()} != expected {ABI_VERSION}")
+    return lib
+
+
+_lib = _load_library()
+
+
+def _check(result, what: str):
+    if result is None or (isinstance(result, int) and result < 0):
+        raise RuntimeError(f"{what} failed: {_lib.ob_last_error().decode()}")
+    return result
+
+
+def _wrap(buf: _Buffer, owner=None) -> np.ndarray:
+    """Zero-copy numpy view of a native buffer; `owner` keeps the memory alive."""
+    dtype = np.dtype(_DTYPES[buf.dtype])
+    shape = tuple(buf.shape[:buf.ndim]) if buf.ndim == 2 else (buf.shape[0],)
+    if not buf.data or buf.shape[0] == 0:
+        return np.empty(shape, dtype=dtype)
+    count = int(np.prod(shape))
+    ctype = ctypes.c_double if dtype == np.float64 else ctypes.c_int32
+    raw = (ctype * count).from_address(buf.data)
+    arr = np.frombuffer(raw, dtype=dtype).reshape(shape)
+    if owner is not None:
+        raw._owner = owner  # numpy keeps `raw` alive, `raw` keeps the owner alive
+    return arr
+
+
+class _NativeArray:
+    """Owns an ob_array; destroyed when the last numpy view is collected."""
+
+    def __init__(self, handle):
+        self.handle = _check(handle, "native array")
+
+    def __del__(self):
+        if getattr(self, "handle", None):
+            _lib.ob_array_destroy(self.handle)
+            self.handle = None
+
+    def numpy(self) -> np.ndarray:
+        return _wrap(_lib.ob_array_buffer(self.handle), owner=self)
+
+
+class Book:
+    def __init__(self, handle=None, owner=None):
+        # owner is set when the book belongs to a Simulator
+        self._owner = owner
+        self._owned = handle is None
+        self.handle = _check(_lib.ob_book_create(), "ob_book_create") if handle is None else handle
+
+    def __del__(self):
+        if getattr(self, "_owned", False) and self.handle:
+            _lib.ob_book_destroy(self.handle)
+            self.handle = None
+
+    def update_bid(self, price: float, volume: float):
+        _lib.ob_book_update_bid(self.handle, price, volume)
+
+    def update_ask(self, price: float, volume: float):
+        _lib.ob_book_update_ask(self.handle, price, volume)
+
+    def clear_level(self, is_bid: bool, price: float):
+        _lib.ob_book_clear_level(self.handle, int(is_bid), price)
+
+    def apply_updates(self, is_bid: np.ndarray, prices: np.ndarray, volumes: np.ndarray):
+        is_bid = np.ascontiguousarray(is_bid, dtype=np.int8)
+        prices = np.ascontiguousarray(prices, dtype=np.float64)
+        volumes = np.ascontiguousarray(volumes, dtype=np.float64)
+        _check(_lib.ob_book_apply_updates(self.handle, is_bid.ctypes.data, prices.ctypes.data,
+                                          volumes.ctypes.data, len(prices)), "ob_book_apply_updates")
+
+    @property
+    def mid_price(self) -> float:
+        return _lib.ob_book_mid_price(self.handle)
+
+    @property
+    def spread(self) -> float:
+        return _lib.ob_book_spread(self.handle)
+
+    def __len__(self) -> int:
+        return _lib.ob_book_history_size(self.handle)
+
+    def history(self) -> np.ndarray:
+        """(T, 27) float64, columns as in Orderbook::saveHistoryToCSV."""
+        return _NativeArray(_lib.ob_book_history(self.handle)).numpy()
+
+
+class Simulator:
+    def __init__(self, initial_price=100.0, tick_size=0.01, levels=10, volatility=0.001, seed=None):
+        """seed=None draws a fresh seed; pass an int for a reproducible book."""
+        if seed is None:
+            seed = secrets.randbits(64)
+        self.handle = _check(_lib.ob_simulator_create(initial_price, tick_size, levels, volatility, seed),
+                             "ob_simulator_create")
+        self.book = Book(_lib.ob_simulator_book(self.handle), owner=self)
+
+    def __del__(self):
+        if getattr(self, "handle", None):
+            _lib.ob_simulator_destroy(self.handle)
+            self.handle = None
+
+    def step(self, ticks: int = 1, event_probability: float = 0.2):
+        _check(_lib.ob_simulator_step(self.handle, ticks, event_probability), "ob_simulator_step")
+
+
+class Extractor:
+    def __init__(self, window: int = 10, volume_normalization: float = 100.0):
+        self.handle = _check(_lib.ob_extractor_create(window, volume_normalization),
+                             "ob_extractor_create")
+
+    def __del__(self):
+        if getattr(self, "handle", None):
+            _lib.ob_extractor_destroy(self.handle)
+            self.handle = None
+
+    def extract(self, book: Book) -> np.ndarray:
+        """(T, 32) float64 features for every state in the book's history."""
+        return _NativeArray(_lib.ob_extractor_extract(self.handle, book.handle)).numpy()
+
+    def label(self, seq_len: int = 10, threshold: float = 0.0005) -> tuple[np.ndarray, np.ndarray]:
+        """Label the last extraction; returns (X: (N, seq_len*32) float64, y: (N,) int32) views."""
+        _check(_lib.ob_extractor_label(self.handle, seq_len, threshold), "ob_extractor_label")
+        X = _wrap(_lib.ob_extractor_sequences(self.handle), owner=self)
+        y = _wrap(_lib.ob_extractor_labels(self.handle), owner=self)
+        return X, y
+
+
+if __name__ == "__main__":
+    sim = Simulator(100.0, 0.05, 10, 0.2)
+    sim.step(3000)
+    print(f"History: {sim.book.history().shape}  mid={sim.book.mid_price:.4f}")
+    ext = Extractor(window=10)
+    feats = ext.extract(sim.book)
+    X, y = ext.label(seq_len=10, threshold=1e-6)
+    print(f"Features: {feats.shape}  Sequences: {X.shape}  Labels: {np.bincount(y, minlength=3)}")
@@ -0,0 +1,93 @@
+"""
+Export MLP weights and the feature scaler for the C++ FPGA dataflow emulator
+(src/orderbook-simulator/FpgaDataflowEmulator.h).
+
+Writes two little-endian binary files:
+  <out>/mlp_regime_<symbol>_h<hidden>.mlpw
+      "MLPW" | uint32 n_layers | per layer: uint32 out, uint32 in,
+      float32 weight[out*in] (torch [out][in] layout), float32 bias[out]
+  <out>/feature_scaler_<symbol>.sclr
+      "SCLR" | uint32 n | float64 mean[n] | float64 scale[n]
+
+The scaler is refit on the symbol's features exactly as quantize_sim.py does,
+so the emulator's fixed-point path sees the same inputs as the Python reference.
+
+Usage:
+    python export_emulator_params.py
+    python export_emulator_params.py --symbol AAPL --hidden 64
+    ./fpga_emulator --lobster ../../data/raw/LOBSTER_SampleFile_AAPL_2012-06-21_5.zip \\
+        --weights results/emulator/mlp_regime_AAPL_h64.mlpw \\
+        --scaler  results/emulator/feature_scaler_AAPL.sclr
+"""
+
+import argparse
+import struct
+import sys
+from pathlib import Path
+
+import numpy as np
+import torch
+
+ROOT = Path(__file__).resolve().parents[2]
+sys.path.insert(0, str(ROOT / "src" / "model"))
+sys.path.insert(0, str(ROOT / "src" / "data"))
+
+from model_mlp import FlatRegimeClassifier, FLAT_DIM, N_REGIMES
+
+RESULTS_DIR = ROOT / "results"
+
+
+def write_weights(model: FlatRegimeClassifier, path: Path):
+    layers = [model.fc1, model.fc2, model.fc3]
+    with open(path, "wb") as f:
+        f.write(b"MLPW")
+        f.write(struct.pack("<I", len(layers)))
+        for layer in layers:
+            w = layer.weight.detach().cpu().numpy().astype("<f4")
+            b = layer.bias.detach().cpu().numpy().astype("<f4")
+            f.write(struct.pack("<II", w.shape[0], w.shape[1]))
+            f.write(w.tobytes())
+            f.write(b.tobytes())
+
+
+def write_scaler(mean: np.ndarray, scale: np.ndarray, path: Path):
+    with open(path, "wb") as f:
+        f.write(b"SCLR")
+        f.write(struct.pack("<I", len(mean)))
+        f.write(mean.astype("<f8").tobytes())
+        f.write(scale.astype("<f8").tobytes())
+
+
+def run(args):
+    from sklearn.preprocessing import StandardScaler
+    from lobster_loader import load_lobster
+    from features import compute_features
+
+    out_dir = Path(args.out)
+    out_dir.mkdir(parents=True, exist_ok=True)
+
+    ckpt = RESULTS_DIR / "models" / f"mlp_regime_{args.symbol}_h{args.hidden}.pth"
+    model = FlatRegimeClassifier(input_dim=FLAT_DIM, hidden=args.hidden, num_classes=N_REGIMES)
+    model.load_state_dict(torch.load(ckpt, weights_only=True, map_location="cpu"))
+    model.eval()
+
+    weights_path = out_dir / f"mlp_regime_{args.symbol}_h{args.hidden}.mlpw"
+    write_weights(model, weights_path)
+    print(f"Wrote {weights_path}")
+
+    ob, msg = load_lobster(args.symbol, "2012-06-21", args.levels)
+    feats_raw = compute_features(ob, n_levels=args.levels, msg=msg)
+    scaler = StandardScaler().fit(feats_raw)
+
+    scaler_path = out_dir / f"feature_scaler_{args.symbol}.sclr"
+    write_scaler(scaler.mean_, scaler.scale_, scaler_path)
+    print(f"Wrote {scaler_path}")
+
+
+if __name__ == "__main__":
+    p = argparse.ArgumentParser()
+    p.add_argument("--symbol", type=str, default="AAPL")
+    p.add_argument("--levels", type=int, default=5)
+    p.add_argument("--hidden", type=int, default=64)
+    p.add_argument("--out",    type=str, default=str(RESULTS_DIR / "emulator"))
+    run(p.parse_args())
@@ -0,0 +1,299 @@
+#include "ArrivalModel.h"
+#include "Checkpoint.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// SplitMix64 finalizer: a pure function of the counter, so a batch has no
+// dependency between elements
+inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+enum ModelTag : uint8_t { POISSON_TAG = 1, HAWKES_TAG = 2 };
+
+template <typename T, size_t N>
+void writeArray(std::ostream& out, const std::array<T, N>& values) {
+    for (const T& v : values) writeBinary(out, v);
+}
+
+template <typename T, size_t N>
+bool readArray(std::istream& in, std::array<T, N>& values) {
+    for (T& v : values) {
+        if (!readBinary(in, v)) return false;
+    }
+    return true;
+}
+
+bool isBidSide(int type) {
+    auto t = static_cast<OrderEventType>(type);
+    return t == OrderEventType::LimitBid || t == OrderEventType::CancelBid || t == OrderEventType::MarketSell;
+}
+
+} // namespace
+
+const char* orderEventTypeName(OrderEventType type) {
+    switch (type) {
+        case OrderEventType::LimitBid: return "LIMIT_BID";
+        case OrderEventType::LimitAsk: return "LIMIT_ASK";
+        case OrderEventType::CancelBid: return "CANCEL_BID";
+        case OrderEventType::CancelAsk: return "CANCEL_ASK";
+        case OrderEventType::MarketBuy: return "MARKET_BUY";
+        case OrderEventType::MarketSell: return "MARKET_SELL";
+    }
+    return "UNKNOWN";
+}
+
+void RandomBuffer::reseed(uint64_t value) {
+    seed = value;
+    counter = 0;
+    uniformPos = BATCH;
+    exponentialPos = BATCH;
+}
+
+void RandomBuffer::fill(double* out, uint64_t at) const {
+    const uint64_t base = seed + at * 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < BATCH; ++i) {
+        uint64_t bits = mix64(base + i * 0x9E3779B97F4A7C15ULL);
+        // Top 53 bits, shifted by one so the result is never 0 (log-safe)
+        out[i] = static_cast<double>((bits >> 11) + 1) * 0x1.0p-53;
+    }
+}
+
+void RandomBuffer::refillUniform() {
+    uniformBatch = counter;
+    fill(uniforms.data(), uniformBatch);
+    counter += BATCH;
+    uniformPos = 0;
+}
+
+void RandomBuffer::refillExponential() {
+    exponentialBatch = counter;
+    fill(exponentials.data(), exponentialBatch);
+    counter += BATCH;
+    for (size_t i = 0; i < BATCH; ++i) exponentials[i] = -std::log(exponentials[i]);
+    exponentialPos = 0;
+}
+
+void RandomBuffer::writeCheckpoint(std::ostream& out) const {
+    writeBinary(out, seed);
+    writeBinary(out, counter);
+    writeBinary(out, uniformBatch);
+    writeBinary(out, exponentialBatch);
+    writeBinary(out, static_cast<uint64_t>(uniformPos));
+    writeBinary(out, static_cast<uint64_t>(exponentialPos));
+}
+
+bool RandomBuffer::readCheckpoint(std::istream& in) {
+    uint64_t newSeed, newCounter, newUniformBatch, newExponentialBatch, newUniformPos, newExponentialPos;
+    if (!readBinary(in, newSeed) || !readBinary(in, newCounter) || !readBinary(in, newUniformBatch) ||
+        !readBinary(in, newExponentialBatch) || !readBinary(in, newUniformPos) ||
+        !readBinary(in, newExponentialPos) || newUniformPos > BATCH || newExponentialPos > BATCH) {
+        return false;
+    }
+
+    seed = newSeed;
+    counter = newCounter;
+    uniformBatch = newUniformBatch;
+    exponentialBatch = newExponentialBatch;
+    uniformPos = newUniformPos;
+    exponentialPos = newExponentialPos;
+    if (uniformPos < BATCH) fill(uniforms.data(), uniformBatch);
+    if (exponentialPos < BATCH) {
+        fill(exponentials.data(), exponentialBatch);
+        for (size_t i = 0; i < BATCH; ++i) exponentials[i] = -std::log(exponentials[i]);
+    }
+    return true;
+}
+
+std::unique_ptr<ArrivalModel> ArrivalModel::readCheckpoint(std::istream& in) {
+    uint8_t tag;
+    if (!readBinary(in, tag)) return nullptr;
+
+    if (tag == POISSON_TAG) {
+        Rates rates;
+        double time;
+        if (!readArray(in, rates) || !readBinary(in, time)) return nullptr;
+        auto model = std::make_unique<PoissonArrivalModel>(rates);
+        model->time = time;
+        return model;
+    }
+
+    if (tag == HAWKES_TAG) {
+        Rates baseline, excitation;
+        HawkesArrivalModel::Matrix alpha;
+        double beta, excitationTotal, time;
+        if (!readArray(in, baseline) || !readBinary(in, beta)) return nullptr;
+        for (auto& row : alpha) {
+            if (!readArray(in, row)) return nullptr;
+        }
+        if (!readArray(in, excitation) || !readBinary(in, excitationTotal) || !readBinary(in, time)) return nullptr;
+        auto model = std::make_unique<HawkesArrivalModel>(baseline, alpha, beta);
+        model->excitation = excitation;
+        model->excitationTotal = excitationTotal;
+        model->time = time;
+        return model;
+    }
+
+    return nullptr;
+}
+
+PoissonArrivalModel::PoissonArrivalModel(const Rates& rates) : rates(rates) {
+    for (double& r : this->rates) r = std::max(r, 0.0);
+    for (double r : this->rates) totalRate += r;
+    if (totalRate <= 0.0) {
+        std::cerr << "Poisson arrival model has no positive rate; using 1 event/s per type" << std::endl;
+        this->rates.fill(1.0);
+        totalRate = NUM_ORDER_EVENT_TYPES;
+    }
+}
+
+inline ArrivalEvent PoissonArrivalModel::draw(RandomBuffer& random) {
+    time += random.exponential() / totalRate;
+    double u = random.uniform() * totalRate;
+    int type = 0;
+    while (type < NUM_ORDER_EVENT_TYPES - 1 && u > rates[type]) u -= rates[type++];
+    return {time, static_cast<OrderEventType>(type)};
+}
+
+ArrivalEvent PoissonArrivalModel::next(RandomBuffer& random) {
+    return draw(random);
+}
+
+void PoissonArrivalModel::generate(RandomBuffer& random, ArrivalEvent* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = draw(random);
+}
+
+void PoissonArrivalModel::writeCheckpoint(std::ostream& out) const {
+    writeBinary(out, static_cast<uint8_t>(POISSON_TAG));
+    writeArray(out, rates);
+    writeBinary(out, time);
+}
+
+HawkesArrivalModel::HawkesArrivalModel(const Rates& baseline, const Matrix& alpha, double beta)
+        : baseline(baseline), alpha(alpha), beta(beta > 0.0 ? beta : 1.0) {
+    for (double& mu : this->baseline) mu = std::max(mu, 0.0);
+    for (double mu : this->baseline) baselineTotal += mu;
+    if (baselineTotal <= 0.0) {
+        std::cerr << "Hawkes arrival model has no positive baseline; using 1 event/s per type" << std::endl;
+        this->baseline.fill(1.0);
+        baselineTotal = NUM_ORDER_EVENT_TYPES;
+    }
+    for (int i = 0; i < NUM_ORDER_EVENT_TYPES; ++i) {
+        for (int j = 0; j < NUM_ORDER_EVENT_TYPES; ++j) {
+            this->alpha[i][j] = std::max(this->alpha[i][j], 0.0);
+            jump[i][j] = this->alpha[i][j] * this->beta;
+        }
+    }
+    if (branchingRatio() >= 1.0) {
+        std::cerr << "Hawkes branching ratio " << branchingRatio()
+                  << " >= 1: the process is explosive and arrivals will not settle" << std::endl;
+    }
+}
+
+HawkesArrivalModel HawkesArrivalModel::withMeanRate(double eventsPerSecond, double branchingRatio, double beta) {
+    branchingRatio = std::min(std::max(branchingRatio, 0.0), 0.99);
+    // Baseline mix per side: 45% limit, 40% cancel, 15% market, roughly the
+    // LOBSTER sample days' message mix
+    const double share[NUM_ORDER_EVENT_TYPES] = {0.225, 0.225, 0.2, 0.2, 0.075, 0.075};
+    Rates mu;
+    for (int i = 0; i < NUM_ORDER_EVENT_TYPES; ++i) mu[i] = eventsPerSecond * (1.0 - branchingRatio) * share[i];
+
+    // Every column sums to branchingRatio: half on the same type, 30% spread
+    // over the rest of the same side, 20% over the opposite side
+    Matrix alpha{};
+    for (int j = 0; j < NUM_ORDER_EVENT_TYPES; ++j) {
+        for (int i = 0; i < NUM_ORDER_EVENT_TYPES; ++i) {
+            double fraction = i == j ? 0.5 : (isBidSide(i) == isBidSide(j) ? 0.15 : 0.2 / 3.0);
+            alpha[i][j] = branchingRatio * fraction;
+        }
+    }
+    return HawkesArrivalModel(mu, alpha, beta);
+}
+
+void HawkesArrivalModel::reset() {
+    excitation.fill(0.0);
+    excitationTotal = 0.0;
+    time = 0.0;
+}
+
+double HawkesArrivalModel::branchingRatio() const {
+    double worst = 0.0;
+    for (int j = 0; j < NUM_ORDER_EVENT_TYPES; ++j) {
+        double column = 0.0;
+        for (int i = 0; i < NUM_ORDER_EVENT_TYPES; ++i) column += alpha[i][j];
+        worst = std::max(worst, column);
+    }
+    return worst;
+}
+
+// Stationary intensities solve lambda = mu + alpha * lambda; iterate the
+// Neumann series, which converges whenever the process is stationary
+double HawkesArrivalModel::meanRate() const {
+    if (branchingRatio() >= 1.0) return INFINITY;
+    Rates lambda = baseline;
+    for (int iter = 0; iter < 1000; ++iter) {
+        Rates nextLambda = baseline;
+        double change = 0.0;
+        for (int i = 0; i < NUM_ORDER_EVENT_TYPES; ++i) {
+            for (int j = 0; j < NUM_ORDER_EVENT_TYPES; ++j) nextLambda[i] += alpha[i][j] * lambda[j];
+            change = std::max(change, std::abs(nextLambda[i] - lambda[i]));
+        }
+        lambda = nextLambda;
+        if (change < 1e-12 * baselineTotal) break;
+    }
+    double total = 0.0;
+    for (double l : lambda) total += l;
+    return total;
+}
+
+inline ArrivalEvent HawkesArrivalModel::draw(RandomBuffer& random) {
+    while (true) {
+        // Intensity only decays until the next arrival, so the current total bounds it
+        double bound = baselineTotal + excitationTotal;
+        double dt = random.exponential() / bound;
+        time += dt;
+
+        double decay = std::exp(-beta * dt);
+        for (double& e : excitation) e *= decay;
+        excitationTotal *= decay;
+
+        // One uniform both accepts the candidate and picks its type
+        double u = random.uniform() * bound;
+        if (u > baselineTotal + excitationTotal) continue;
+
+        int type = 0;
+        for (; type < NUM_ORDER_EVENT_TYPES - 1; ++type) {
+            double intensity = baseline[type] + excitation[type];
+            if (u <= intensity) break;
+            u -= intensity;
+        }
+        for (int i = 0; i < NUM_ORDER_EVENT_TYPES; ++i) {
+            excitation[i] += jump[i][type];
+            excitationTotal += jump[i][type];
+        }
+        return {time, static_cast<OrderEventType>(type)};
+    }
+}
+
+ArrivalEvent HawkesArrivalModel::next(RandomBuffer& random) {
+    return draw(random);
+}
+
+void HawkesArrivalModel::generate(RandomBuffer& random, ArrivalEvent* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = draw(random);
+}
+
+void HawkesArrivalModel::writeCheckpoint(std::ostream& out) const {
+    writeBinary(out, static_cast<uint8_t>(HAWKES_TAG));
+    writeArray(out, baseline);
+    writeBinary(out, beta);
+    for (const auto& row : alpha) writeArray(out, row);
+    writeArray(out, excitation);
+    writeBinary(out, excitationTotal);
+    writeBinary(out, time);
+}
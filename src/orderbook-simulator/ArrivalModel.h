@@ -0,0 +1,179 @@
+/*
+ * File: ArrivalModel.h
+ *
+ * Description:
+ * Order arrival processes for the simulator's event-driven mode. Each arrival
+ * is one of six event types (limit / cancel / market, per side), stamped with
+ * a model time in seconds.
+ *
+ *   PoissonArrivalModel - independent homogeneous Poisson streams per type
+ *   HawkesArrivalModel  - multivariate Hawkes process with exponential kernels
+ *                         sharing one decay rate, so an event of type j raises
+ *                         the intensity of type i by alpha[i][j] * beta and that
+ *                         excitation decays as exp(-beta * t). Arrivals cluster
+ *                         into bursts; alpha[i][j] is the expected number of
+ *                         type-i children per type-j event (branching ratio).
+ *
+ * Hawkes paths are drawn by Ogata thinning. With a single decay rate the
+ * intensity only falls between events, so the current total is a valid bound
+ * and each candidate costs one exp().
+ *
+ * Random variates come from RandomBuffer: a counter-based generator that
+ * fills fixed batches of uniforms and unit exponentials in tight loops with
+ * no loop-carried state, so they vectorize, and models consume from the
+ * buffer instead of drawing one by one.
+ *
+ * Models and buffers checkpoint their full state (parameters, Hawkes
+ * excitation, generator position), so a restored simulator continues the
+ * exact arrival path; see Checkpoint.h.
+ */
+
+#ifndef ORDERBOOK_ARRIVALMODEL_H
+#define ORDERBOOK_ARRIVALMODEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+enum class OrderEventType : int {
+    LimitBid,
+    LimitAsk,
+    CancelBid,
+    CancelAsk,
+    MarketBuy,      // consumes the ask side
+    MarketSell,     // consumes the bid side
+};
+
+constexpr int NUM_ORDER_EVENT_TYPES = 6;
+
+const char* orderEventTypeName(OrderEventType type);
+
+struct ArrivalEvent {
+    double time = 0.0;      // model seconds since reset()
+    OrderEventType type = OrderEventType::LimitBid;
+};
+
+class RandomBuffer {
+public:
+    static constexpr size_t BATCH = 4096;
+
+    explicit RandomBuffer(uint64_t seed = 0x2545F4914F6CDD1DULL) { reseed(seed); }
+
+    void reseed(uint64_t seed);
+
+    // Uniform on (0, 1]
+    double uniform() {
+        if (uniformPos == BATCH) refillUniform();
+        return uniforms[uniformPos++];
+    }
+
+    // Exponential with rate 1
+    double exponential() {
+        if (exponentialPos == BATCH) refillExponential();
+        return exponentials[exponentialPos++];
+    }
+
+    // Position only; the current batches are regenerated from their counters on restore
+    void writeCheckpoint(std::ostream& out) const;
+    bool readCheckpoint(std::istream& in);
+
+private:
+    void refillUniform();
+    void refillExponential();
+    void fill(double* out, uint64_t at) const;
+
+    uint64_t seed = 0;
+    uint64_t counter = 0;
+    uint64_t uniformBatch = 0;          // counter each current batch was filled from
+    uint64_t exponentialBatch = 0;
+    std::array<double, BATCH> uniforms{};
+    std::array<double, BATCH> exponentials{};
+    size_t uniformPos = BATCH;
+    size_t exponentialPos = BATCH;
+};
+
+class ArrivalModel {
+public:
+    using Rates = std::array<double, NUM_ORDER_EVENT_TYPES>;
+
+    virtual ~ArrivalModel() = default;
+
+    virtual std::string name() const = 0;
+    virtual void reset() = 0;
+    virtual double meanRate() const = 0;    // stationary events per second, all types
+
+    virtual ArrivalEvent next(RandomBuffer& random) = 0;
+    // Bulk generation; implemented per model so next() inlines into the loop
+    virtual void generate(RandomBuffer& random, ArrivalEvent* out, size_t count) = 0;
+
+    // Type tag, parameters and process state; readCheckpoint rebuilds the model (nullptr if corrupt)
+    virtual void writeCheckpoint(std::ostream& out) const = 0;
+    static std::unique_ptr<ArrivalModel> readCheckpoint(std::istream& in);
+};
+
+class PoissonArrivalModel final : public ArrivalModel {
+public:
+    explicit PoissonArrivalModel(const Rates& rates);
+
+    std::string name() const override { return "poisson"; }
+    void reset() override { time = 0.0; }
+    double meanRate() const override { return totalRate; }
+
+    ArrivalEvent next(RandomBuffer& random) override;
+    void generate(RandomBuffer& random, ArrivalEvent* out, size_t count) override;
+
+    void writeCheckpoint(std::ostream& out) const override;
+
+private:
+    friend class ArrivalModel;
+    ArrivalEvent draw(RandomBuffer& random);
+
+    Rates rates;
+    double totalRate = 0.0;
+    double time = 0.0;
+};
+
+class HawkesArrivalModel final : public ArrivalModel {
+public:
+    using Matrix = std::array<Rates, NUM_ORDER_EVENT_TYPES>;
+
+    // baseline: mu per type; alpha[i][j]: branching ratio from type j to type i; beta: decay per second
+    HawkesArrivalModel(const Rates& baseline, const Matrix& alpha, double beta);
+
+    // Symmetric book with the given stationary rate and a limit/cancel/market
+    // baseline mix; each event mostly excites its own type, then the same
+    // side, then the opposite side
+    static HawkesArrivalModel withMeanRate(double eventsPerSecond, double branchingRatio = 0.7,
+                                           double beta = 1000.0);
+
+    std::string name() const override { return "hawkes"; }
+    void reset() override;
+    double meanRate() const override;
+
+    ArrivalEvent next(RandomBuffer& random) override;
+    void generate(RandomBuffer& random, ArrivalEvent* out, size_t count) override;
+
+    double branchingRatio() const;   // largest column sum of alpha; < 1 for a stationary process
+
+    void writeCheckpoint(std::ostream& out) const override;
+
+private:
+    friend class ArrivalModel;
+    ArrivalEvent draw(RandomBuffer& random);
+
+    Rates baseline;
+    Matrix jump;            // alpha * beta, added to the excitation on arrival
+    Matrix alpha;
+    double beta;
+    double baselineTotal = 0.0;
+
+    Rates excitation{};
+    double excitationTotal = 0.0;
+    double time = 0.0;
+};
+
+#endif // ORDERBOOK_ARRIVALMODEL_H
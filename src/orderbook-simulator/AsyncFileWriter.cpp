@@ -0,0 +1,533 @@
+#include "AsyncFileWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+// Completion of submitted block writes; only the owning AsyncFileWriter thread calls in
+class AsyncWriteBackend {
+public:
+    virtual ~AsyncWriteBackend() = default;
+    virtual void submitWrite(int block, const char* data, size_t bytes, uint64_t offset) = 0;
+    virtual void submitSync() = 0;                  // ordered after every earlier write
+    virtual bool busy(int block) = 0;
+    virtual void waitFor(int block) = 0;
+    virtual void drain() = 0;
+    virtual int error() const = 0;                  // first errno seen, 0 if none
+};
+
+namespace {
+
+// After a short write to an O_DIRECT descriptor the remainder is unaligned, so it
+// continues through `bufferedFd` when one is given
+bool pwriteAll(int fd, const char* data, size_t bytes, uint64_t offset, int bufferedFd = -1) {
+    while (bytes > 0) {
+        ssize_t n = ::pwrite(fd, data, bytes, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        bytes -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+        if (bufferedFd >= 0) fd = bufferedFd;
+    }
+    return true;
+}
+
+class IoUringBackend : public AsyncWriteBackend {
+public:
+    static std::unique_ptr<IoUringBackend> create(int fd, int bufferedFd, int blocks) {
+        std::unique_ptr<IoUringBackend> ring(new IoUringBackend(fd, bufferedFd, blocks));
+        if (!ring->setup()) return nullptr;
+        return ring;
+    }
+
+    ~IoUringBackend() override {
+        if (ringFd >= 0) drain();
+        if (sqes) munmap(sqes, sqesBytes);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingBytes);
+        if (sqRing) munmap(sqRing, sqRingBytes);
+        if (ringFd >= 0) ::close(ringFd);
+    }
+
+    void submitWrite(int block, const char* data, size_t bytes, uint64_t offset) override {
+        pending[block] = {data, bytes, offset};
+        inFlight[block] = true;
+        queueWrite(block);
+    }
+
+    void submitSync() override {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->flags = IOSQE_IO_DRAIN;
+        sqe->fd = fd;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->user_data = SYNC_TAG;
+        submit();
+    }
+
+    bool busy(int block) override { return inFlight[block]; }
+
+    void waitFor(int block) override {
+        while (inFlight[block] && reap(true)) {}
+    }
+
+    void drain() override {
+        while (outstanding > 0 && reap(true)) {}
+    }
+
+    int error() const override { return firstError; }
+
+private:
+    struct PendingWrite {
+        const char* data = nullptr;
+        size_t bytes = 0;
+        uint64_t offset = 0;
+    };
+
+    static constexpr uint64_t SYNC_TAG = ~0ull;
+
+    IoUringBackend(int fd, int bufferedFd, int blocks)
+            : fd(fd), bufferedFd(bufferedFd), pending(blocks), inFlight(blocks, false) {}
+
+    static int enter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    bool setup() {
+        // Room for every block plus one drained fsync per block
+        unsigned entries = 8;
+        while (entries < 2 * pending.size()) entries <<= 1;
+
+        io_uring_params params{};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd < 0 || !supportsWrite()) return false;
+
+        sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+
+        sqRing = mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            return false;
+        }
+        if (singleMmap) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                cqRing = nullptr;
+                return false;
+            }
+        }
+        sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) return false;
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+        char* sq = static_cast<char*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // Kernels 5.1-5.5 have io_uring but not IORING_OP_WRITE (writes fail with EINVAL);
+    // IORING_REGISTER_PROBE arrived with it in 5.6, so a failed probe means no support
+    bool supportsWrite() const {
+        const unsigned maxOps = 256;
+        std::vector<uint64_t> storage((sizeof(io_uring_probe) + maxOps * sizeof(io_uring_probe_op)) / sizeof(uint64_t) + 1, 0);
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, maxOps) < 0) return false;
+        return IORING_OP_WRITE <= probe->last_op && IORING_OP_WRITE < probe->ops_len &&
+               (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    io_uring_sqe* nextSqe() {
+        unsigned tail = *sqTail;
+        unsigned index = tail & sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        return sqe;
+    }
+
+    // Entries are submitted one at a time, so the SQ never holds more than one. On a
+    // hard error the kernel has not taken the entry: withdraw it so that no completion
+    // is awaited for it, and return false
+    bool submit() {
+        unsigned tail = *sqTail;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++outstanding;
+        while (enter(ringFd, 1, 0, 0) < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                reap(false);
+                continue;
+            }
+            recordError(errno);
+            if (__atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == tail) {
+                __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+                --outstanding;
+                return false;
+            }
+            break;      // consumed after all; its completion will arrive
+        }
+        return true;
+    }
+
+    void queueWrite(int block) {
+        const PendingWrite& w = pending[block];
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(w.data);
+        sqe->len = static_cast<uint32_t>(w.bytes);
+        sqe->off = w.offset;
+        sqe->user_data = static_cast<uint64_t>(block);
+        if (!submit()) inFlight[block] = false;
+    }
+
+    // Consumes available completions, waiting for at least one if asked; false on a dead ring
+    bool reap(bool wait) {
+        unsigned head = *cqHead;
+        if (wait && head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            if (enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                recordError(errno);
+                outstanding = 0;
+                std::fill(inFlight.begin(), inFlight.end(), false);
+                return false;
+            }
+        }
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes[head & cqMask];
+            uint64_t tag = cqe.user_data;
+            int res = cqe.res;
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+            --outstanding;
+            if (tag == SYNC_TAG) {
+                if (res < 0) recordError(-res);
+                continue;
+            }
+            int block = static_cast<int>(tag);
+            PendingWrite& w = pending[block];
+            if (res < 0) {
+                recordError(-res);
+                inFlight[block] = false;
+            } else if (static_cast<size_t>(res) < w.bytes) {
+                // Short write: resubmit the remainder. O_DIRECT would reject its unaligned
+                // offset, so with a buffered descriptor it is finished synchronously there
+                w.data += res;
+                w.bytes -= static_cast<size_t>(res);
+                w.offset += static_cast<uint64_t>(res);
+                if (bufferedFd < 0) {
+                    queueWrite(block);
+                } else {
+                    if (!pwriteAll(bufferedFd, w.data, w.bytes, w.offset)) recordError(errno);
+                    inFlight[block] = false;
+                }
+            } else {
+                inFlight[block] = false;
+            }
+        }
+        return true;
+    }
+
+    void recordError(int err) {
+        if (firstError == 0) firstError = err;
+    }
+
+    int fd;
+    int bufferedFd;                     // -1 unless fd is O_DIRECT
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqRingBytes = 0;
+    size_t cqRingBytes = 0;
+    size_t sqesBytes = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    std::vector<PendingWrite> pending;
+    std::vector<bool> inFlight;
+    int outstanding = 0;
+    int firstError = 0;
+};
+
+class ThreadBackend : public AsyncWriteBackend {
+public:
+    ThreadBackend(int fd, int bufferedFd, int blocks) : fd(fd), bufferedFd(bufferedFd), inFlight(blocks, false) {
+        worker = std::thread([this] { run(); });
+    }
+
+    ~ThreadBackend() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    void submitWrite(int block, const char* data, size_t bytes, uint64_t offset) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight[block] = true;
+            jobs.push_back({block, data, bytes, offset});
+        }
+        wake.notify_all();
+    }
+
+    void submitSync() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back({-1, nullptr, 0, 0});
+        }
+        wake.notify_all();
+    }
+
+    bool busy(int block) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return inFlight[block];
+    }
+
+    void waitFor(int block) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return !inFlight[block]; });
+    }
+
+    void drain() override {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return jobs.empty() && !working; });
+    }
+
+    int error() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return firstError;
+    }
+
+private:
+    struct Job {
+        int block;                      // -1 = fdatasync
+        const char* data;
+        size_t bytes;
+        uint64_t offset;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            Job job = jobs.front();
+            jobs.pop_front();
+            working = true;
+            lock.unlock();
+
+            bool ok = job.block < 0 ? ::fdatasync(fd) == 0 : pwriteAll(fd, job.data, job.bytes, job.offset, bufferedFd);
+            int err = ok ? 0 : errno;
+
+            lock.lock();
+            if (!ok && firstError == 0) firstError = err;
+            if (job.block >= 0) inFlight[job.block] = false;
+            working = false;
+            done.notify_all();
+        }
+    }
+
+    int fd;
+    int bufferedFd;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::deque<Job> jobs;
+    std::vector<bool> inFlight;
+    bool working = false;
+    bool stopping = false;
+    int firstError = 0;
+    std::thread worker;
+};
+
+size_t roundUp(size_t n, size_t alignment) {
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+AsyncFileWriter::AsyncFileWriter() = default;
+
+AsyncFileWriter::~AsyncFileWriter() {
+    if (isOpen()) close();
+}
+
+bool AsyncFileWriter::open(const std::string& filePath) {
+    return open(filePath, Config());
+}
+
+bool AsyncFileWriter::open(const std::string& filePath, const Config& cfg) {
+    if (isOpen()) close();
+    path = filePath;
+    config = cfg;
+    config.blockSize = roundUp(std::max<size_t>(config.blockSize, BLOCK_ALIGNMENT), BLOCK_ALIGNMENT);
+    config.blocks = std::max(config.blocks, 2);
+
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    direct = false;
+    if (config.direct) {
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+        if (fd >= 0) {
+            direct = true;
+        } else if (errno == EINVAL) {
+            std::cerr << "O_DIRECT not supported for " << path << "; writing through the page cache" << std::endl;
+        }
+    }
+    if (fd < 0) fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        std::cerr << "Could not open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Unaligned writes (short-write remainders, patches) need a descriptor without O_DIRECT
+    bufferedFd = direct ? ::open(path.c_str(), O_WRONLY | O_CLOEXEC) : -1;
+    if (direct && bufferedFd < 0) {
+        std::cerr << "Could not open " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    blocks.clear();
+    for (int i = 0; i < config.blocks; ++i) {
+        char* block = static_cast<char*>(std::aligned_alloc(BLOCK_ALIGNMENT, config.blockSize));
+        if (!block) {
+            std::cerr << "Could not allocate " << config.blocks << " x " << config.blockSize
+                      << " byte buffers for " << path << std::endl;
+            blocks.clear();
+            if (bufferedFd >= 0) ::close(bufferedFd);
+            bufferedFd = -1;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        blocks.emplace_back(block);
+    }
+
+    ioUring = false;
+    if (config.backend != Backend::Thread) {
+        backend = IoUringBackend::create(fd, bufferedFd, config.blocks);
+        ioUring = backend != nullptr;
+        if (!ioUring && config.backend == Backend::IoUring) {
+            std::cerr << "io_uring unavailable; using a writer thread for " << path << std::endl;
+        }
+    }
+    if (!backend) backend = std::make_unique<ThreadBackend>(fd, bufferedFd, config.blocks);
+
+    current = 0;
+    fill = 0;
+    blockOffset = 0;
+    blocksSubmitted = 0;
+    stallCount = 0;
+    patches.clear();
+    return true;
+}
+
+void AsyncFileWriter::write(const void* data, size_t bytes) {
+    const char* src = static_cast<const char*>(data);
+    while (bytes > 0) {
+        size_t n = std::min(bytes, config.blockSize - fill);
+        std::memcpy(blocks[current].get() + fill, src, n);
+        fill += n;
+        src += n;
+        bytes -= n;
+        if (fill == config.blockSize) submitBlock();
+    }
+}
+
+void AsyncFileWriter::patch(uint64_t offset, const void* data, size_t bytes) {
+    const char* src = static_cast<const char*>(data);
+    patches.push_back({offset, std::vector<char>(src, src + bytes)});
+}
+
+void AsyncFileWriter::submitBlock() {
+    // O_DIRECT needs aligned lengths; the zero padding of the last block is truncated on close
+    size_t length = fill;
+    if (direct && length % BLOCK_ALIGNMENT != 0) {
+        size_t padded = roundUp(length, BLOCK_ALIGNMENT);
+        std::memset(blocks[current].get() + length, 0, padded - length);
+        length = padded;
+    }
+    backend->submitWrite(current, blocks[current].get(), length, blockOffset);
+    ++blocksSubmitted;
+    if (config.syncEveryBlocks > 0 && blocksSubmitted % config.syncEveryBlocks == 0) backend->submitSync();
+
+    blockOffset += fill;
+    fill = 0;
+    current = (current + 1) % config.blocks;
+    if (backend->busy(current)) {
+        ++stallCount;
+        backend->waitFor(current);
+    }
+}
+
+bool AsyncFileWriter::close() {
+    if (!isOpen()) return false;
+    uint64_t logicalSize = size();
+    if (fill > 0) submitBlock();
+    backend->drain();
+    int err = backend->error();
+    backend.reset();
+    bool ok = err == 0;
+
+    if (ok && direct && ::ftruncate(fd, static_cast<off_t>(logicalSize)) != 0) {
+        err = errno;
+        ok = false;
+    }
+    if (ok && !patches.empty()) {
+        // Patches are small and unaligned, so they go through the buffered descriptor
+        int patchFd = direct ? bufferedFd : fd;
+        for (const auto& p : patches) {
+            if (!pwriteAll(patchFd, p.bytes.data(), p.bytes.size(), p.offset)) {
+                err = errno;
+                ok = false;
+                break;
+            }
+        }
+    }
+    if (ok && config.syncEveryBlocks > 0 && ::fdatasync(fd) != 0) {
+        err = errno;
+        ok = false;
+    }
+    if (!ok) std::cerr << "Write to " << path << " failed: " << std::strerror(err) << std::endl;
+
+    if (bufferedFd >= 0) ::close(bufferedFd);
+    bufferedFd = -1;
+    ::close(fd);
+    fd = -1;
+    blocks.clear();
+    patches.clear();
+    return ok;
+}
@@ -0,0 +1,101 @@
+/*
+ * File: AsyncFileWriter.h
+ *
+ * Description:
+ * Sequential file writer that keeps disk I/O off the producing thread. write()
+ * only copies into the current block; full blocks are handed to the kernel
+ * asynchronously while the next one fills (double buffering by default), so
+ * the producer waits only if it gets a whole block ahead of the disk. close()
+ * flushes just the last, partial block.
+ *
+ * Backends:
+ *   IoUring - io_uring via raw syscalls (no liburing dependency); one
+ *             IORING_OP_WRITE per block, fdatasync as a drained IORING_OP_FSYNC
+ *   Thread  - a writer thread issuing pwrite / fdatasync in submission order
+ *   Auto    - io_uring when the kernel allows it and supports IORING_OP_WRITE
+ *             (probed; 5.6+), otherwise the thread
+ *
+ * Blocks are 4 KiB aligned, so the file can be opened with O_DIRECT to bypass
+ * the page cache; the padded tail is truncated back on close. Filesystems that
+ * refuse O_DIRECT (tmpfs) fall back to buffered writes. The remainder of a short
+ * O_DIRECT write is unaligned, so it is finished through a second, buffered
+ * descriptor, as are the header patches. With syncEveryBlocks
+ * set, fdatasync is batched every N blocks and once more at close; otherwise
+ * durability is left to the page cache, like std::ofstream.
+ *
+ * Headers whose values are only known at the end (record counts) are written
+ * as placeholders and fixed up with patch(), which is applied during close().
+ */
+
+#ifndef ORDERBOOK_ASYNCFILEWRITER_H
+#define ORDERBOOK_ASYNCFILEWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+class AsyncWriteBackend;
+
+class AsyncFileWriter {
+public:
+    enum class Backend { Auto, IoUring, Thread };
+
+    struct Config {
+        Backend backend = Backend::Auto;
+        size_t blockSize = 1 << 20;     // rounded up to BLOCK_ALIGNMENT
+        int blocks = 2;                 // buffers in rotation (>= 2)
+        bool direct = false;            // O_DIRECT
+        int syncEveryBlocks = 0;        // fdatasync every N blocks and at close; 0 = never
+    };
+
+    static constexpr size_t BLOCK_ALIGNMENT = 4096;
+
+    AsyncFileWriter();
+    ~AsyncFileWriter();
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    bool open(const std::string& path);                 // default Config
+    bool open(const std::string& path, const Config& config);
+    void write(const void* data, size_t bytes);
+    // Overwrite already-written bytes once everything else is on disk (during close)
+    void patch(uint64_t offset, const void* data, size_t bytes);
+    bool close();                       // false if any write failed
+
+    bool isOpen() const { return fd >= 0; }
+    bool usingIoUring() const { return ioUring; }
+    bool isDirect() const { return direct; }
+    uint64_t size() const { return blockOffset + fill; }
+    uint64_t stalls() const { return stallCount; }     // write() waits on an in-flight block
+
+private:
+    struct FreeDeleter {
+        void operator()(char* p) const { std::free(p); }
+    };
+    struct Patch {
+        uint64_t offset;
+        std::vector<char> bytes;
+    };
+
+    void submitBlock();
+
+    std::string path;
+    Config config;
+    int fd = -1;
+    int bufferedFd = -1;                // second, buffered descriptor when direct
+    bool direct = false;
+    bool ioUring = false;
+    std::unique_ptr<AsyncWriteBackend> backend;
+    std::vector<std::unique_ptr<char, FreeDeleter>> blocks;
+    int current = 0;
+    size_t fill = 0;
+    uint64_t blockOffset = 0;           // file offset of the current block
+    uint64_t blocksSubmitted = 0;
+    uint64_t stallCount = 0;
+    std::vector<Patch> patches;
+};
+
+#endif // ORDERBOOK_ASYNCFILEWRITER_H
@@ -0,0 +1,455 @@
+#include "Backtester.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <tuple>
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+std::string regimeList(uint8_t mask) {
+    std::string list;
+    for (int r = 0; r < BacktestTape::NUM_REGIMES; ++r) {
+        if (mask & (1u << r)) list += static_cast<char>('0' + r);
+    }
+    return list.empty() ? "-" : list;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Tape
+// ---------------------------------------------------------------------------
+
+BacktestTape BacktestTape::fromHistory(const Orderbook::History& history, const LobsterMessages* messages) {
+    BacktestTape tape;
+    size_t n = history.size();
+    tape.time.resize(n);
+    tape.mid.resize(n);
+    for (int l = 0; l < LEVELS; ++l) {
+        tape.bidPrice[l].assign(n, 0.0);
+        tape.bidSize[l].assign(n, 0.0);
+        tape.askPrice[l].assign(n, 0.0);
+        tape.askSize[l].assign(n, 0.0);
+    }
+    tape.bidExecuted.assign(n, 0.0);
+    tape.askExecuted.assign(n, 0.0);
+    tape.regime.assign(n, -1);
+    tape.direction.assign(n, -1);
+
+    const bool haveExecutions = messages && messages->rows() == n;
+    double lastMid = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const Orderbook::State& state = history[i];
+        tape.time[i] = state.timestamp;
+        if (state.midPrice > 0.0) lastMid = state.midPrice;
+        tape.mid[i] = lastMid;
+
+        for (int l = 0; l < LEVELS; ++l) {
+            if (static_cast<size_t>(l) < state.bidLevels.size()) {
+                tape.bidPrice[l][i] = state.bidLevels[l].price;
+                tape.bidSize[l][i] = state.bidLevels[l].volume;
+            }
+            if (static_cast<size_t>(l) < state.askLevels.size()) {
+                tape.askPrice[l][i] = state.askLevels[l].price;
+                tape.askSize[l][i] = state.askLevels[l].volume;
+            }
+        }
+
+        // Type 4 executes a visible limit order: a buy order (+1) trades at the bid
+        if (haveExecutions && messages->type[i] == 4) {
+            if (messages->direction[i] > 0) {
+                tape.bidExecuted[i] = messages->size[i];
+            } else {
+                tape.askExecuted[i] = messages->size[i];
+            }
+        }
+    }
+    return tape;
+}
+
+void BacktestTape::computeRegimes(SignalPipeline& pipeline, const Orderbook::History& history,
+                                  const std::vector<int32_t>* messageTypes) {
+    pipeline.reset();
+    regime.assign(history.size(), -1);
+    for (size_t i = 0; i < history.size(); ++i) {
+        int type = messageTypes && i < messageTypes->size() ? (*messageTypes)[i] : -1;
+        int signal = pipeline.onEvent(history[i], type);
+        regime[i] = static_cast<int8_t>(signal >= 0 && signal < NUM_REGIMES ? signal : -1);
+    }
+}
+
+void BacktestTape::labelDirections(int horizon, double threshold) {
+    size_t n = size();
+    direction.assign(n, -1);
+    for (size_t i = 0; i + horizon < n; ++i) {
+        if (mid[i] <= 0.0) continue;
+        double futureReturn = (mid[i + horizon] - mid[i]) / mid[i];
+        if (futureReturn > threshold) {
+            direction[i] = 0;  // Up
+        } else if (futureReturn < -threshold) {
+            direction[i] = 1;  // Down
+        } else {
+            direction[i] = 2;  // No significant change
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sweep and results
+// ---------------------------------------------------------------------------
+
+void BacktestSweep::add(const StrategyParams& params) {
+    regimeMask.push_back(params.regimeMask);
+    passive.push_back(params.passive ? 1 : 0);
+    latency.push_back(params.latency);
+    signalAccuracy.push_back(params.signalAccuracy);
+    maxHold.push_back(params.maxHold);
+    cancelAhead.push_back(params.cancelAhead);
+    orderSize.push_back(params.orderSize);
+}
+
+StrategyParams BacktestSweep::get(size_t i) const {
+    StrategyParams params;
+    params.regimeMask = regimeMask[i];
+    params.passive = passive[i] != 0;
+    params.latency = latency[i];
+    params.signalAccuracy = signalAccuracy[i];
+    params.maxHold = maxHold[i];
+    params.cancelAhead = cancelAhead[i];
+    params.orderSize = orderSize[i];
+    return params;
+}
+
+BacktestSweep BacktestSweep::grid(const std::vector<uint8_t>& regimeMasks, const std::vector<bool>& passiveModes,
+                                  const std::vector<double>& latencies, const std::vector<double>& accuracies,
+                                  const std::vector<double>& maxHolds, const std::vector<double>& cancelAheads,
+                                  double orderSize) {
+    BacktestSweep sweep;
+    StrategyParams params;
+    params.orderSize = orderSize;
+    for (uint8_t mask : regimeMasks)
+        for (bool passive : passiveModes)
+            for (double latency : latencies)
+                for (double accuracy : accuracies)
+                    for (double hold : maxHolds)
+                        for (double cancelAhead : cancelAheads) {
+                            // Queue assumptions do not affect aggressive orders
+                            if (!passive && cancelAhead != cancelAheads.front()) continue;
+                            params.regimeMask = mask;
+                            params.passive = passive;
+                            params.latency = latency;
+                            params.signalAccuracy = accuracy;
+                            params.maxHold = hold;
+                            params.cancelAhead = cancelAhead;
+                            sweep.add(params);
+                        }
+    return sweep;
+}
+
+void BacktestResults::resize(size_t n) {
+    pnl.assign(n, 0.0);
+    fees.assign(n, 0.0);
+    maxDrawdown.assign(n, 0.0);
+    volume.assign(n, 0.0);
+    fills.assign(n, 0);
+    exposure.assign(n, 0.0);
+}
+
+// ---------------------------------------------------------------------------
+// Engine
+// ---------------------------------------------------------------------------
+
+Backtester::Backtester(Config config) : config(config) {
+    if (this->config.comboBlock == 0) this->config.comboBlock = 1;
+}
+
+BacktestResults Backtester::run(const BacktestTape& tape, const BacktestSweep& sweep, ThreadPool& pool) const {
+    BacktestResults results;
+    results.resize(sweep.size());
+    size_t numBlocks = (sweep.size() + config.comboBlock - 1) / config.comboBlock;
+    pool.parallelFor(numBlocks, [&](size_t b) {
+        size_t begin = b * config.comboBlock;
+        size_t end = std::min(sweep.size(), begin + config.comboBlock);
+        runBlock(tape, sweep, begin, end, results);
+    });
+    return results;
+}
+
+void Backtester::runBlock(const BacktestTape& tape, const BacktestSweep& sweep, size_t begin, size_t end,
+                          BacktestResults& results) const {
+    const size_t n = end - begin;
+    const uint8_t* regimeMask = sweep.regimeMask.data() + begin;
+    const uint8_t* passive = sweep.passive.data() + begin;
+    const double* latency = sweep.latency.data() + begin;
+    const double* accuracy = sweep.signalAccuracy.data() + begin;
+    const double* maxHold = sweep.maxHold.data() + begin;
+    const double* cancelAhead = sweep.cancelAhead.data() + begin;
+    const double* orderSize = sweep.orderSize.data() + begin;
+
+    // Position and PnL
+    std::vector<double> position(n, 0.0), cash(n, 0.0), fees(n, 0.0), volume(n, 0.0);
+    std::vector<double> peak(n, 0.0), drawdown(n, 0.0), exposure(n, 0.0), entryTime(n, 0.0);
+    std::vector<uint32_t> fills(n, 0);
+    std::vector<int8_t> target(n, 0);
+    // The working order: signed quantity left, 0 = none
+    std::vector<double> orderQty(n, 0.0), activateAt(n, 0.0), orderPrice(n, 0.0);
+    std::vector<double> queueAhead(n, 0.0), levelVolume(n, 0.0);
+    std::vector<uint8_t> resting(n, 0);
+
+    const uint64_t seed = mix64(config.seed);
+    double prevTime = tape.size() > 0 ? tape.time[0] : 0.0;
+
+    for (size_t i = 0; i < tape.size(); ++i) {
+        const double t = tape.time[i];
+        const double dt = t - prevTime;
+        prevTime = t;
+        const double mid = tape.mid[i];
+        const int regime = tape.regime[i];
+        const int label = tape.direction[i];
+        const double bid0 = tape.bidPrice[0][i];
+        const double ask0 = tape.askPrice[0][i];
+        const double bidSize0 = tape.bidSize[0][i];
+        const double askSize0 = tape.askSize[0][i];
+        // Nothing can trade against a crossed or locked snapshot (the simulator's book can cross)
+        const bool bookCrossed = bid0 > 0.0 && ask0 > 0.0 && bid0 >= ask0;
+        // Common random numbers: one draw per event, shared by every combination, so a lower
+        // accuracy corrupts a superset of the labels a higher one does, with the same wrong class
+        const uint64_t draw = mix64(seed ^ (static_cast<uint64_t>(i) * 0xD1B54A32D192ED03ull));
+        const double u = static_cast<double>(draw >> 11) * 0x1.0p-53;
+        const int wrongLabel = label >= 0 ? (label + 1 + static_cast<int>(draw & 1)) % 3 : label;
+
+        for (size_t k = 0; k < n; ++k) {
+            if (position[k] != 0.0) exposure[k] += dt;
+
+            auto fill = [&](double qty, double price, double feePerShare) {
+                double before = position[k];
+                position[k] += qty;
+                cash[k] -= qty * price + std::abs(qty) * feePerShare;
+                fees[k] += std::abs(qty) * feePerShare;
+                volume[k] += std::abs(qty);
+                ++fills[k];
+                orderQty[k] -= qty;
+                if (std::abs(orderQty[k]) < 1e-9) {
+                    orderQty[k] = 0.0;
+                    resting[k] = 0;
+                }
+                if (before == 0.0 || (before > 0.0) != (position[k] > 0.0)) entryTime[k] = t;
+            };
+
+            // Direction signal, degraded to the combination's accuracy
+            const int dir = u >= accuracy[k] ? wrongLabel : label;
+
+            int8_t want = target[k];
+            if (regime < 0 || !((regimeMask[k] >> regime) & 1)) {
+                want = 0;
+            } else if (dir == 0) {
+                want = 1;
+            } else if (dir == 1) {
+                want = -1;
+            } else if (dir == 2 && position[k] != 0.0 && t - entryTime[k] >= maxHold[k]) {
+                want = 0;
+            }
+            if (want != target[k]) {
+                // Supersedes any working order
+                target[k] = want;
+                orderQty[k] = want * orderSize[k] - position[k];
+                activateAt[k] = t + latency[k];
+                resting[k] = 0;
+            }
+
+            if (orderQty[k] != 0.0 && t >= activateAt[k] && !bookCrossed) {
+                const bool buy = orderQty[k] > 0.0;
+                if (!passive[k]) {
+                    // Walk the opposite side; the remainder retries on the next event
+                    for (int l = 0; l < BacktestTape::LEVELS && orderQty[k] != 0.0; ++l) {
+                        double price = buy ? tape.askPrice[l][i] : tape.bidPrice[l][i];
+                        double size = buy ? tape.askSize[l][i] : tape.bidSize[l][i];
+                        if (price <= 0.0 || size <= 0.0) break;
+                        double take = std::min(std::abs(orderQty[k]), size);
+                        fill(buy ? take : -take, price, config.takerFee);
+                    }
+                } else if (!resting[k]) {
+                    double touch = buy ? bid0 : ask0;
+                    if (touch > 0.0) {
+                        orderPrice[k] = touch;
+                        queueAhead[k] = buy ? bidSize0 : askSize0;
+                        levelVolume[k] = queueAhead[k];
+                        resting[k] = 1;
+                    }
+                } else {
+                    const double price = orderPrice[k];
+                    const double touch = buy ? bid0 : ask0;
+                    const double opposite = buy ? ask0 : bid0;
+                    const double executed = buy ? tape.bidExecuted[i] : tape.askExecuted[i];
+                    const bool crossed = opposite > 0.0 && (buy ? opposite <= price : opposite >= price);
+                    const bool through = touch <= 0.0 || (buy ? touch < price : touch > price);
+                    if (crossed || through) {
+                        // The level is gone, but only executions past the queue ahead reached the
+                        // order; if cancels emptied it instead, join the new touch at the back
+                        if (executed > queueAhead[k]) {
+                            double qty = std::min(std::abs(orderQty[k]), executed - queueAhead[k]);
+                            fill(buy ? qty : -qty, price, -config.makerRebate);
+                        }
+                        if (orderQty[k] != 0.0) {
+                            resting[k] = 0;
+                            activateAt[k] = t + latency[k];
+                        }
+                    } else if (touch != price) {
+                        // The touch moved away: re-peg after another round trip
+                        resting[k] = 0;
+                        activateAt[k] = t + latency[k];
+                    } else {
+                        double visible = buy ? bidSize0 : askSize0;
+                        double cancelled = std::max(0.0, levelVolume[k] - visible - executed);
+                        double ahead = queueAhead[k];
+                        if (executed > ahead) {
+                            double qty = std::min(std::abs(orderQty[k]), executed - ahead);
+                            ahead = 0.0;
+                            fill(buy ? qty : -qty, price, -config.makerRebate);
+                        } else {
+                            ahead -= executed;
+                        }
+                        queueAhead[k] = std::max(0.0, ahead - cancelAhead[k] * cancelled);
+                        levelVolume[k] = visible;
+                    }
+                }
+            }
+
+            double equity = cash[k] + position[k] * mid;
+            peak[k] = std::max(peak[k], equity);
+            drawdown[k] = std::max(drawdown[k], peak[k] - equity);
+        }
+    }
+
+    const double finalMid = tape.size() > 0 ? tape.mid.back() : 0.0;
+    for (size_t k = 0; k < n; ++k) {
+        results.pnl[begin + k] = cash[k] + position[k] * finalMid;
+        results.fees[begin + k] = fees[k];
+        results.maxDrawdown[begin + k] = drawdown[k];
+        results.volume[begin + k] = volume[k];
+        results.fills[begin + k] = fills[k];
+        results.exposure[begin + k] = exposure[k];
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Reporting
+// ---------------------------------------------------------------------------
+
+void Backtester::printTop(const BacktestResults& results, const BacktestSweep& sweep, size_t count, std::ostream& out) {
+    std::vector<size_t> order(results.size());
+    std::iota(order.begin(), order.end(), 0);
+    count = std::min(count, order.size());
+    std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                      [&](size_t a, size_t b) { return results.pnl[a] > results.pnl[b]; });
+
+    out << std::setw(12) << "pnl" << std::setw(10) << "fees" << std::setw(10) << "max_dd"
+        << std::setw(8) << "fills" << std::setw(10) << "volume" << std::setw(10) << "exposure"
+        << "   regimes mode  latency_us accuracy hold_s cancel_ahead" << std::endl;
+    out << std::fixed;
+    for (size_t r = 0; r < count; ++r) {
+        size_t i = order[r];
+        out << std::setprecision(2)
+            << std::setw(12) << results.pnl[i] << std::setw(10) << results.fees[i]
+            << std::setw(10) << results.maxDrawdown[i] << std::setw(8) << results.fills[i]
+            << std::setprecision(0) << std::setw(10) << results.volume[i]
+            << std::setprecision(1) << std::setw(9) << results.exposure[i] << "s"
+            << "   " << std::setw(7) << regimeList(sweep.regimeMask[i])
+            << (sweep.passive[i] ? " pass" : " aggr")
+            << std::setprecision(0) << std::setw(12) << sweep.latency[i] * 1e6
+            << std::setprecision(2) << std::setw(9) << sweep.signalAccuracy[i]
+            << std::setprecision(1) << std::setw(7) << sweep.maxHold[i]
+            << std::setprecision(2) << std::setw(13) << sweep.cancelAhead[i] << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+bool Backtester::writeCsv(const BacktestResults& results, const BacktestSweep& sweep, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    out << "regime_mask,passive,latency_s,signal_accuracy,max_hold_s,cancel_ahead,order_size,"
+           "pnl,fees,max_drawdown,fills,volume,exposure_s\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        out << int(sweep.regimeMask[i]) << ',' << int(sweep.passive[i]) << ','
+            << sweep.latency[i] << ',' << sweep.signalAccuracy[i] << ',' << sweep.maxHold[i] << ','
+            << sweep.cancelAhead[i] << ',' << sweep.orderSize[i] << ','
+            << results.pnl[i] << ',' << results.fees[i] << ',' << results.maxDrawdown[i] << ','
+            << results.fills[i] << ',' << results.volume[i] << ',' << results.exposure[i] << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool Backtester::checkAccuracyOrdering(const BacktestResults& results, const BacktestSweep& sweep, std::ostream& out) {
+    // Pair every combination with the one that differs only in accuracy, at the highest accuracy
+    using Key = std::tuple<uint8_t, uint8_t, double, double, double, double>;
+    auto keyOf = [&](size_t i) {
+        return Key{sweep.regimeMask[i], sweep.passive[i], sweep.latency[i], sweep.maxHold[i],
+                   sweep.cancelAhead[i], sweep.orderSize[i]};
+    };
+    double topAccuracy[2] = {-1.0, -1.0};
+    for (size_t i = 0; i < results.size(); ++i) {
+        double& top = topAccuracy[sweep.passive[i] ? 1 : 0];
+        top = std::max(top, sweep.signalAccuracy[i]);
+    }
+    std::map<Key, double> topPnl;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (sweep.signalAccuracy[i] == topAccuracy[sweep.passive[i] ? 1 : 0]) topPnl[keyOf(i)] = results.pnl[i];
+    }
+
+    struct Cell {
+        double pnl = 0.0;
+        size_t count = 0;
+        size_t compared = 0;
+        size_t beats = 0;           // pairs where this accuracy earned more than the top one
+    };
+    // Highest accuracy first, for aggressive [0] and passive [1] orders
+    std::map<double, Cell, std::greater<double>> cells[2];
+    for (size_t i = 0; i < results.size(); ++i) {
+        const int mode = sweep.passive[i] ? 1 : 0;
+        Cell& cell = cells[mode][sweep.signalAccuracy[i]];
+        cell.pnl += results.pnl[i];
+        ++cell.count;
+        auto top = topPnl.find(keyOf(i));
+        if (sweep.signalAccuracy[i] < topAccuracy[mode] && top != topPnl.end()) {
+            ++cell.compared;
+            if (results.pnl[i] > top->second) ++cell.beats;
+        }
+    }
+
+    // Inventory held on a degraded signal swings with the market, so single pairs can go
+    // either way; a worse signal that wins most of them points at the fill model instead
+    bool ok = true;
+    out << "Mean PnL by signal accuracy (share of combinations beating the highest accuracy)" << std::endl
+        << std::fixed;
+    for (int mode = 1; mode >= 0; --mode) {
+        for (const auto& [accuracy, cell] : cells[mode]) {
+            out << (mode ? "  pass" : "  aggr") << std::setprecision(2) << std::setw(9) << accuracy
+                << std::setw(14) << cell.pnl / cell.count;
+            if (cell.compared > 0) {
+                double share = static_cast<double>(cell.beats) / cell.compared;
+                bool suspicious = 2 * cell.beats > cell.compared;
+                ok = ok && !suspicious;
+                out << std::setprecision(0) << std::setw(8) << 100.0 * share << "%"
+                    << (suspicious ? "   <- a worse signal wins most pairs" : "");
+            }
+            out << std::endl;
+        }
+    }
+    out << std::defaultfloat;
+    return ok;
+}
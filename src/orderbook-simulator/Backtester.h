@@ -0,0 +1,153 @@
+/*
+ * File: Backtester.h
+ *
+ * Description:
+ * Event-driven backtest of regime-conditioned directional strategies, built
+ * to sweep thousands of parameter combinations over full days at once.
+ *
+ * BacktestTape holds the market as columns (top levels, mid, visible
+ * executions at the touch) plus two signals per event: the predicted regime
+ * (4 classes from the MLP, see src/data/regime_labels.py) and a direction
+ * class as produced by FeatureExtractor::prepareLabeledData (0 up, 1 down,
+ * 2 flat). Direction labels look ahead by construction; a combination's
+ * signalAccuracy replaces a share of them with wrong classes to stand in for
+ * a model of that accuracy. The replacement draw depends on the event only,
+ * so lower accuracies corrupt nested supersets of the same labels and
+ * accuracy comparisons are paired (common random numbers).
+ *
+ * Strategy: while the predicted regime is enabled in regimeMask, hold
+ * +orderSize on "up" and -orderSize on "down"; "flat" exits once the
+ * position is older than maxHold seconds; a disabled regime exits at once.
+ * Each change of target sends one order for the difference, live `latency`
+ * seconds later:
+ *   aggressive - takes liquidity, walking the visible levels of that event's
+ *                book; whatever the book cannot fill retries on later events
+ *   passive    - joins the own-side touch behind the visible size there.
+ *                Executions at that price consume the queue ahead first and
+ *                then fill the order; cancellations advance the queue by
+ *                cancelAhead of their size (0 = all cancels were behind us,
+ *                1 = all ahead). A touch that moves away re-pegs after
+ *                another latency. When the touch goes through the order's
+ *                price, only that event's executions past the queue ahead
+ *                fill it; the rest re-pegs at the new touch, since the
+ *                level may have been emptied by cancels.
+ * Cancels of a superseded order take effect immediately, and orders neither
+ * fill nor join while the snapshot is crossed or locked. Fills pay the taker
+ * fee or earn the maker rebate; PnL marks the position to mid.
+ *
+ * Parameters and per-combination state are structs of arrays. Combinations
+ * are split into blocks on a ThreadPool and every block walks the whole tape,
+ * so the tape is read sequentially and a block's state stays in cache.
+ */
+
+#ifndef ORDERBOOK_BACKTESTER_H
+#define ORDERBOOK_BACKTESTER_H
+
+#include "LobsterIngest.h"
+#include "Orderbook.h"
+#include "ReplayHarness.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct BacktestTape {
+    static constexpr int LEVELS = 5;
+    static constexpr int NUM_REGIMES = 4;
+
+    std::vector<double> time;
+    std::vector<double> mid;                    // last valid mid while a side is empty
+    std::vector<double> bidPrice[LEVELS];       // 0 price and size past the last level
+    std::vector<double> bidSize[LEVELS];
+    std::vector<double> askPrice[LEVELS];
+    std::vector<double> askSize[LEVELS];
+    std::vector<double> bidExecuted;            // visible volume executed at the best bid (sells)
+    std::vector<double> askExecuted;            // visible volume executed at the best ask (buys)
+    std::vector<int8_t> regime;                 // 0..NUM_REGIMES-1, -1 = no prediction
+    std::vector<int8_t> direction;              // 0 up, 1 down, 2 flat, -1 = no label
+
+    size_t size() const { return time.size(); }
+
+    // Executions come from LOBSTER type-4 messages when `messages` is row-aligned with the
+    // history; without them passive orders only advance on cancellations and never fill
+    static BacktestTape fromHistory(const Orderbook::History& history, const LobsterMessages* messages = nullptr);
+
+    // Regime per event from a signal pipeline (e.g. MlpSignalPipeline); -1 while it warms up
+    void computeRegimes(SignalPipeline& pipeline, const Orderbook::History& history,
+                        const std::vector<int32_t>* messageTypes = nullptr);
+    // prepareLabeledData's rule: mid return `horizon` events ahead against +/- threshold
+    void labelDirections(int horizon = 5, double threshold = 0.0005);
+};
+
+struct StrategyParams {
+    uint8_t regimeMask = 0xF;           // bit r enables trading in regime r
+    bool passive = true;
+    double latency = 0.0;               // seconds from decision to live order
+    double signalAccuracy = 1.0;        // share of direction labels kept
+    double maxHold = 0.0;               // seconds before a flat signal exits
+    double cancelAhead = 0.5;           // share of cancelled volume that was queued ahead
+    double orderSize = 100.0;           // shares
+};
+
+// Parameter combinations as columns
+struct BacktestSweep {
+    std::vector<uint8_t> regimeMask;
+    std::vector<uint8_t> passive;
+    std::vector<double> latency;
+    std::vector<double> signalAccuracy;
+    std::vector<double> maxHold;
+    std::vector<double> cancelAhead;
+    std::vector<double> orderSize;
+
+    size_t size() const { return regimeMask.size(); }
+    void add(const StrategyParams& params);
+    StrategyParams get(size_t i) const;
+
+    // Cartesian product of the given values
+    static BacktestSweep grid(const std::vector<uint8_t>& regimeMasks, const std::vector<bool>& passiveModes,
+                              const std::vector<double>& latencies, const std::vector<double>& accuracies,
+                              const std::vector<double>& maxHolds, const std::vector<double>& cancelAheads,
+                              double orderSize = 100.0);
+};
+
+struct BacktestResults {
+    std::vector<double> pnl;                // final equity (cash + position at mid), after fees
+    std::vector<double> fees;               // taker fees minus maker rebates
+    std::vector<double> maxDrawdown;
+    std::vector<double> volume;             // shares traded
+    std::vector<uint32_t> fills;
+    std::vector<double> exposure;           // seconds with a non-zero position
+
+    size_t size() const { return pnl.size(); }
+    void resize(size_t n);
+};
+
+class Backtester {
+public:
+    struct Config {
+        double takerFee = 0.0030;           // $ per share
+        double makerRebate = 0.0020;        // $ per share
+        size_t comboBlock = 64;             // combinations per task
+        uint64_t seed = 1;                  // signal-degradation draws
+    };
+
+    explicit Backtester(Config config);
+
+    BacktestResults run(const BacktestTape& tape, const BacktestSweep& sweep, ThreadPool& pool) const;
+
+    static void printTop(const BacktestResults& results, const BacktestSweep& sweep, size_t count, std::ostream& out);
+    static bool writeCsv(const BacktestResults& results, const BacktestSweep& sweep, const std::string& path);
+    // Sanity check: prints mean PnL per signal accuracy and order mode; false when a lower
+    // accuracy out-earns the highest one in most otherwise identical combinations
+    static bool checkAccuracyOrdering(const BacktestResults& results, const BacktestSweep& sweep, std::ostream& out);
+
+private:
+    void runBlock(const BacktestTape& tape, const BacktestSweep& sweep, size_t begin, size_t end,
+                  BacktestResults& results) const;
+
+    Config config;
+};
+
+#endif // ORDERBOOK_BACKTESTER_H
@@ -0,0 +1,139 @@
+#include "BarSampler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+double sideChange(const std::pmr::vector<Orderbook::Level>& prev, const std::pmr::vector<Orderbook::Level>& curr) {
+    double change = 0.0;
+    for (const auto& c : curr) {
+        auto it = std::find_if(prev.begin(), prev.end(), [&](const Orderbook::Level& p) { return p.price == c.price; });
+        change += it == prev.end() ? c.volume : std::abs(c.volume - it->volume);
+    }
+    for (const auto& p : prev) {
+        bool kept = std::any_of(curr.begin(), curr.end(), [&](const Orderbook::Level& c) { return c.price == p.price; });
+        if (!kept) change += p.volume;
+    }
+    return change;
+}
+
+} // namespace
+
+BarSampler::BarSampler(Config config) : config(config) {
+    if (this->config.threshold <= 0.0) {
+        std::cerr << "Bar threshold must be positive; using 1" << std::endl;
+        this->config.threshold = 1.0;
+    }
+}
+
+void BarSampler::reset() {
+    barOpen = false;
+    havePrevious = false;
+    current = Bar();
+    closed = Bar();
+}
+
+bool BarSampler::push(const Orderbook::State& state) {
+    bool emitted = false;
+
+    // A time bar is closed by the first snapshot past its end, which opens the next one
+    if (config.type == Type::Time && barOpen && state.timestamp >= barEndTime) {
+        closeBar();
+        emitted = true;
+    }
+    if (!barOpen) openBar(state);
+    addToBar(state);
+
+    switch (config.type) {
+        case Type::Time:
+            break;
+        case Type::Tick:
+            if (current.updates >= config.threshold) emitted = true;
+            break;
+        case Type::Volume:
+            if (current.volume >= config.threshold) emitted = true;
+            break;
+        case Type::Imbalance:
+            if (std::abs(current.imbalance) >= config.threshold) emitted = true;
+            break;
+    }
+    if (emitted && config.type != Type::Time) closeBar();
+    return emitted;
+}
+
+bool BarSampler::flush() {
+    if (!barOpen) return false;
+    closeBar();
+    return true;
+}
+
+std::vector<Bar> BarSampler::sample(const Orderbook::History& history) {
+    reset();
+    std::vector<Bar> bars;
+    for (const auto& state : history) {
+        if (push(state)) bars.push_back(closed);
+    }
+    if (flush()) bars.push_back(closed);
+    return bars;
+}
+
+Orderbook::History BarSampler::closingStates(const std::vector<Bar>& bars, std::pmr::memory_resource* resource) {
+    Orderbook::History states(resource);
+    states.reserve(bars.size());
+    for (const auto& bar : bars) states.push_back(bar.closeState);
+    return states;
+}
+
+void BarSampler::openBar(const Orderbook::State& state) {
+    current = Bar();
+    current.openTime = state.timestamp;
+    if (config.type == Type::Time) {
+        barEndTime = (std::floor(state.timestamp / config.threshold) + 1.0) * config.threshold;
+    }
+    barOpen = true;
+}
+
+void BarSampler::addToBar(const Orderbook::State& state) {
+    if (havePrevious) {
+        current.volume += changedVolume(previous, state);
+        current.imbalance += orderFlowImbalance(previous, state);
+    }
+
+    // Snapshots with an empty side have no mid and do not move OHLC
+    Price mid = state.midPrice;
+    if (mid > 0.0) {
+        if (current.open <= 0.0) {
+            current.open = current.high = current.low = mid;
+        }
+        current.high = std::max(current.high, mid);
+        current.low = std::min(current.low, mid);
+        current.close = mid;
+    }
+    current.closeTime = state.timestamp;
+    ++current.updates;
+
+    // The most recent snapshot doubles as the bar's closing state
+    previous = state;
+    havePrevious = true;
+}
+
+void BarSampler::closeBar() {
+    closed = current;
+    closed.closeState = previous;
+    barOpen = false;
+}
+
+double BarSampler::changedVolume(const Orderbook::State& prev, const Orderbook::State& curr) {
+    return sideChange(prev.bidLevels, curr.bidLevels) + sideChange(prev.askLevels, curr.askLevels);
+}
+
+// Best-level order flow imbalance: bid-side arrivals minus ask-side arrivals
+double BarSampler::orderFlowImbalance(const Orderbook::State& prev, const Orderbook::State& curr) {
+    double flow = 0.0;
+    if (curr.bestBid.first >= prev.bestBid.first) flow += curr.bestBid.second;
+    if (curr.bestBid.first <= prev.bestBid.first) flow -= prev.bestBid.second;
+    if (curr.bestAsk.first <= prev.bestAsk.first) flow -= curr.bestAsk.second;
+    if (curr.bestAsk.first >= prev.bestAsk.first) flow += prev.bestAsk.second;
+    return flow;
+}
@@ -0,0 +1,83 @@
+/*
+ * File: BarSampler.h
+ *
+ * Description:
+ * Event-driven sampling between the order book and the FeatureExtractor. The
+ * raw history holds one snapshot per level update (about 2 * levels per
+ * generateUpdate), most of them near-identical. BarSampler aggregates that
+ * stream into bars and hands the extractor one closing snapshot per bar.
+ *
+ * Bar types (threshold meaning):
+ *   Time      - fixed clock intervals, aligned to multiples of the threshold (seconds)
+ *   Tick      - every N snapshots
+ *   Volume    - once the resting volume that changed in the top levels reaches N
+ *   Imbalance - once |cumulative order flow imbalance| at the touch reaches N
+ *
+ * Each bar keeps mid-price OHLC, changed volume, signed order flow imbalance
+ * (Cont, Kukanov and Stoikov) and the number of snapshots, all updated
+ * incrementally per snapshot without buffering the bar's states.
+ */
+
+#ifndef ORDERBOOK_BARSAMPLER_H
+#define ORDERBOOK_BARSAMPLER_H
+
+#include "Orderbook.h"
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+struct Bar {
+    double openTime = 0.0;
+    double closeTime = 0.0;
+    Price open = 0.0;
+    Price high = 0.0;
+    Price low = 0.0;
+    Price close = 0.0;
+    Volume volume = 0.0;        // sum of |resting volume change| over the visible levels
+    double imbalance = 0.0;     // sum of best-level order flow imbalance
+    uint32_t updates = 0;       // snapshots aggregated
+    Orderbook::State closeState;
+};
+
+class BarSampler {
+public:
+    enum class Type { Time, Tick, Volume, Imbalance };
+
+    struct Config {
+        Type type = Type::Tick;
+        double threshold = 20.0;
+    };
+
+    explicit BarSampler(Config config);
+
+    // Feed one snapshot; returns true when a bar closed (read it with lastBar())
+    bool push(const Orderbook::State& state);
+    // Close the partial bar, if any; returns true when one was emitted
+    bool flush();
+    const Bar& lastBar() const { return closed; }
+    void reset();
+
+    // Whole-history convenience: every closed bar plus the trailing partial one
+    std::vector<Bar> sample(const Orderbook::History& history);
+
+    // Closing snapshots, timestamped at bar close, ready for FeatureExtractor::extractFeatures
+    static Orderbook::History closingStates(const std::vector<Bar>& bars,
+                                            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+private:
+    void openBar(const Orderbook::State& state);
+    void addToBar(const Orderbook::State& state);
+    void closeBar();
+    static double changedVolume(const Orderbook::State& prev, const Orderbook::State& curr);
+    static double orderFlowImbalance(const Orderbook::State& prev, const Orderbook::State& curr);
+
+    Config config;
+    Bar current;
+    Bar closed;
+    bool barOpen = false;
+    bool havePrevious = false;
+    Orderbook::State previous;
+    double barEndTime = 0.0;    // time bars only
+};
+
+#endif // ORDERBOOK_BARSAMPLER_H
@@ -0,0 +1,79 @@
+#include "Checkpoint.h"
+#include "OrderbookSimulator.h"
+#include "FeatureExtraction.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool saveCheckpoint(const std::string& path, const OrderbookSimulator& simulator,
+                    const FeatureExtractor* extractor) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open checkpoint file for writing: " << path << std::endl;
+        return false;
+    }
+
+    uint32_t flags = extractor ? CHECKPOINT_HAS_EXTRACTOR : 0;
+    file.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    writeBinary(file, CHECKPOINT_VERSION);
+    writeBinary(file, flags);
+
+    simulator.writeCheckpoint(file);
+    if (extractor) extractor->writeCheckpoint(file);
+
+    if (!file) {
+        std::cerr << "Failed writing checkpoint: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadCheckpoint(const std::string& path, OrderbookSimulator& simulator,
+                    FeatureExtractor* extractor) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        std::cerr << "Failed to open checkpoint file for reading: " << path << std::endl;
+        return false;
+    }
+    std::stringstream file;
+    file << input.rdbuf();
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    uint32_t version, flags;
+    file.read(magic, sizeof(magic));
+    if (!file || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 ||
+        !readBinary(file, version) || version != CHECKPOINT_VERSION ||
+        !readBinary(file, flags)) {
+        std::cerr << "Not a valid checkpoint (or unsupported version): " << path << std::endl;
+        return false;
+    }
+
+    // Dry run into scratch objects, so a block that fails late cannot leave the
+    // simulator restored and the extractor not
+    const std::streampos body = file.tellg();
+    const bool restoreExtractor = extractor && (flags & CHECKPOINT_HAS_EXTRACTOR);
+    {
+        OrderbookSimulator scratchSimulator;
+        if (!scratchSimulator.readCheckpoint(file)) {
+            std::cerr << "Corrupt simulator block in checkpoint: " << path << std::endl;
+            return false;
+        }
+        FeatureExtractor scratchExtractor;
+        if (restoreExtractor && !scratchExtractor.readCheckpoint(file)) {
+            std::cerr << "Corrupt extractor block in checkpoint: " << path << std::endl;
+            return false;
+        }
+    }
+
+    file.clear();
+    file.seekg(body);
+    if (!simulator.readCheckpoint(file) || (restoreExtractor && !extractor->readCheckpoint(file))) {
+        std::cerr << "Failed to restore checkpoint: " << path << std::endl;
+        return false;
+    }
+    if (extractor && !restoreExtractor) {
+        std::cerr << "Checkpoint has no extractor state, extractor left cold: " << path << std::endl;
+    }
+    return true;
+}
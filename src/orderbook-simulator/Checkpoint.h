@@ -0,0 +1,74 @@
+/*
+ * File: Checkpoint.h
+ *
+ * Description:
+ * Binary checkpointing of the live simulation pipeline. A checkpoint captures
+ * everything needed to resume generation exactly where it stopped: the order
+ * book levels, the simulator's price/RNG state, pending scheduled updates and
+ * event-driven arrival state (model, Hawkes excitation, generator position),
+ * and (optionally) the FeatureExtractor's rolling windows so features are warm
+ * immediately after a restart.
+ *
+ * The snapshot history of the book is NOT part of a checkpoint; it is output
+ * data and is written separately (saveHistoryToCSV / saveToFiles). Keeping it
+ * out is what makes restores take microseconds regardless of run length.
+ *
+ * Restores are all-or-nothing: each readCheckpoint parses into temporaries and
+ * commits only once its whole block has been read.
+ *
+ * File layout (little-endian, native doubles):
+ *   magic "OBCK" | uint32 version | uint32 flags | simulator block | [extractor block]
+ */
+
+#ifndef ORDERBOOK_CHECKPOINT_H
+#define ORDERBOOK_CHECKPOINT_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+
+class OrderbookSimulator;
+class FeatureExtractor;
+
+constexpr char CHECKPOINT_MAGIC[4] = {'O', 'B', 'C', 'K'};
+constexpr uint32_t CHECKPOINT_VERSION = 3;            // 2: tick count, 3: arrival model state
+constexpr uint32_t CHECKPOINT_HAS_EXTRACTOR = 1u << 0;
+// Longest string a checkpoint holds (the engine state text is ~7 KB); anything longer is corruption
+constexpr uint64_t CHECKPOINT_MAX_STRING = 1u << 20;
+
+// Raw POD helpers shared by the writeCheckpoint/readCheckpoint members
+template <typename T>
+inline void writeBinary(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+inline bool readBinary(std::istream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+inline void writeString(std::ostream& out, const std::string& s) {
+    writeBinary(out, static_cast<uint64_t>(s.size()));
+    out.write(s.data(), s.size());
+}
+
+inline bool readString(std::istream& in, std::string& s) {
+    uint64_t size;
+    if (!readBinary(in, size) || size > CHECKPOINT_MAX_STRING) return false;
+    std::string value(size, '\0');
+    if (size > 0 && !in.read(&value[0], static_cast<std::streamsize>(size))) return false;
+    s = std::move(value);
+    return true;
+}
+
+// Save / restore a simulator and, optionally, a feature extractor to one file. A load
+// checks the whole file against scratch objects first, so on failure nothing is modified.
+bool saveCheckpoint(const std::string& path, const OrderbookSimulator& simulator,
+                    const FeatureExtractor* extractor = nullptr);
+bool loadCheckpoint(const std::string& path, OrderbookSimulator& simulator,
+                    FeatureExtractor* extractor = nullptr);
+
+#endif // ORDERBOOK_CHECKPOINT_H
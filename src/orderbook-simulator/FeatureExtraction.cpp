@@ -3,6 +3,8 @@
 //
 
 #include "FeatureExtraction.h"
+#include "Checkpoint.h"
+#include <algorithm>
 #include <cmath>
 #include <numeric>
 #include <fstream>
@@ -10,50 +12,139 @@
 
 // Convert feature struct to flat vector for ML
 std::vector<double> OrderbookFeature::toVector() const {
-    std::vector<double> vec;
+    std::vector<double> vec(DIMENSION);
+    writeTo(vec.data());
+    return vec;
+}
 
+void OrderbookFeature::writeTo(double* out) const {
     // Add all features in order
-    vec.push_back(priceChange);
-    vec.push_back(spread);
-    vec.push_back(spreadPct);
-    vec.push_back(sizeImbalance);
-    vec.push_back(vwmp);
-    vec.push_back(vwmpDiff);
+    *out++ = priceChange;
+    *out++ = spread;
+    *out++ = spreadPct;
+    *out++ = sizeImbalance;
+    *out++ = vwmp;
+    *out++ = vwmpDiff;
 
     // Add arrays
-    for (int i = 0; i < 5; i++) vec.push_back(bidDistances[i]);
-    for (int i = 0; i < 5; i++) vec.push_back(askDistances[i]);
-    for (int i = 0; i < 5; i++) vec.push_back(bidSizesNorm[i]);
-    for (int i = 0; i < 5; i++) vec.push_back(askSizesNorm[i]);
+    for (int i = 0; i < 5; i++) *out++ = bidDistances[i];
+    for (int i = 0; i < 5; i++) *out++ = askDistances[i];
+    for (int i = 0; i < 5; i++) *out++ = bidSizesNorm[i];
+    for (int i = 0; i < 5; i++) *out++ = askSizesNorm[i];
 
     // Add rolling statistics
-    vec.push_back(volatility);
-    vec.push_back(priceMom1);
-    vec.push_back(priceMom5);
-    vec.push_back(priceMom10);
-    vec.push_back(priceTrend);
-    vec.push_back(spreadTrend);
-
-    return vec;
+    *out++ = volatility;
+    *out++ = priceMom1;
+    *out++ = priceMom5;
+    *out++ = priceMom10;
+    *out++ = priceTrend;
+    *out++ = spreadTrend;
 }
 
-FeatureExtractor::FeatureExtractor(int priceFeatureWindow, double volumeNormalization)
-        : priceFeatureWindow(priceFeatureWindow), volumeNormalization(volumeNormalization) {
+FeatureExtractor::FeatureExtractor(int priceFeatureWindow, double volumeNormalization,
+                                   std::pmr::memory_resource* resource)
+        : priceFeatureWindow(priceFeatureWindow), volumeNormalization(volumeNormalization),
+          resource(resource), featureVectors(resource), labels(resource) {
 }
 
-std::vector<OrderbookFeature> FeatureExtractor::extractFeatures(const std::vector<Orderbook::State>& states) {
+std::vector<OrderbookFeature> FeatureExtractor::extractFeatures(const Orderbook::History& states) {
     std::vector<OrderbookFeature> features;
+    features.reserve(states.size());
+
+    const bool fitting = normalizer && !normalizer->isFrozen() && normalizer->dimension() == OrderbookFeature::DIMENSION;
+    double row[OrderbookFeature::DIMENSION];
+    for (const auto& state : states) {
+        features.push_back(extractFeature(state));
+        if (fitting) {
+            features.back().writeTo(row);
+            normalizer->observe(row);
+        }
+    }
+
+    return features;
+}
+
+std::vector<OrderbookFeature> FeatureExtractor::extractFeatures(const Orderbook::History& states, ThreadPool& pool) {
+    const size_t n = states.size();
+    const size_t numChunks = std::min(pool.size(), n / MIN_PARALLEL_CHUNK);
+    if (numChunks <= 1) return extractFeatures(states);
+
+    // The windows hold priceFeatureWindow mids and price changes; the oldest change
+    // also needs the mid before it, hence one extra warm-up state
+    const size_t warmup = static_cast<size_t>(priceFeatureWindow) + 1;
+    const bool fitting = normalizer && !normalizer->isFrozen() && normalizer->dimension() == OrderbookFeature::DIMENSION;
+
+    std::vector<OrderbookFeature> features(n);
+    std::vector<FeatureExtractor> chunkExtractors;
+    std::vector<FeatureNormalizer> chunkStats;
+    chunkExtractors.reserve(numChunks);
+    for (size_t c = 0; c < numChunks; ++c) {
+        chunkExtractors.emplace_back(priceFeatureWindow, volumeNormalization);
+        if (fitting) chunkStats.emplace_back(OrderbookFeature::DIMENSION);
+    }
+
+    // The first chunk continues from this extractor's windows (e.g. a restored checkpoint)
+    FeatureExtractor& head = chunkExtractors.front();
+    head.priceHistory = priceHistory;
+    head.priceChangeHistory = priceChangeHistory;
+    head.spreadHistory = spreadHistory;
+
+    pool.parallelFor(numChunks, [&](size_t c) {
+        size_t begin = n * c / numChunks;
+        size_t end = n * (c + 1) / numChunks;
+        FeatureExtractor& local = chunkExtractors[c];
+        for (size_t i = begin > warmup ? begin - warmup : 0; i < begin; ++i) local.extractFeature(states[i]);
+
+        double row[OrderbookFeature::DIMENSION];
+        for (size_t i = begin; i < end; ++i) {
+            features[i] = local.extractFeature(states[i]);
+            if (fitting) {
+                features[i].writeTo(row);
+                chunkStats[c].observe(row);
+            }
+        }
+    });
+
+    if (fitting) {
+        for (const auto& stats : chunkStats) normalizer->merge(stats);
+    }
+
+    // Leave the windows where the sequential pass would
+    const FeatureExtractor& last = chunkExtractors.back();
+    priceHistory = last.priceHistory;
+    priceChangeHistory = last.priceChangeHistory;
+    spreadHistory = last.spreadHistory;
+    return features;
+}
 
-    // Clear history
+void FeatureExtractor::resetWindows() {
     priceHistory.clear();
     priceChangeHistory.clear();
     spreadHistory.clear();
+    deployedFeatures.reset();
+}
 
-    for (const auto& state : states) {
-        features.push_back(extractFeature(state));
+std::vector<DeployedFeatureSet::Row> FeatureExtractor::extractDeployedFeatures(
+        const Orderbook::History& states, const std::vector<int32_t>* messageTypes) {
+    std::vector<DeployedFeatureSet::Row> rows(states.size());
+    const bool fitting = normalizer && !normalizer->isFrozen() && normalizer->dimension() == DeployedFeatureSet::WIDTH;
+    const bool haveTypes = messageTypes && messageTypes->size() == states.size();
+    for (size_t i = 0; i < states.size(); ++i) {
+        deployedFeatures.compute(states[i], haveTypes ? (*messageTypes)[i] : -1, rows[i]);
+        if (fitting) normalizer->observe(rows[i].values);
     }
+    return rows;
+}
 
-    return features;
+void FeatureExtractor::setNormalizer(FeatureNormalizer* featureNormalizer) {
+    if (featureNormalizer && featureNormalizer->dimension() != OrderbookFeature::DIMENSION &&
+        featureNormalizer->dimension() != DeployedFeatureSet::WIDTH) {
+        std::cerr << "Normalizer has " << featureNormalizer->dimension() << " features, expected "
+                  << OrderbookFeature::DIMENSION << " or " << DeployedFeatureSet::WIDTH
+                  << "; normalization disabled" << std::endl;
+        featureNormalizer = nullptr;
+    }
+    normalizer = featureNormalizer;
 }
 
 OrderbookFeature FeatureExtractor::extractFeature(const Orderbook::State& state) {
@@ -171,61 +262,160 @@ OrderbookFeature FeatureExtractor::extractFeature(const Orderbook::State& state)
 void FeatureExtractor::prepareLabeledData(const std::vector<OrderbookFeature>& features,
                                           const std::vector<double>& midPrices,
                                           int sequenceLength, double threshold) {
-    int horizon = 5;
+    auto writeRow = [&features](size_t i, double* out) { features[i].writeTo(out); };
+    buildLabeledData(features.size(), OrderbookFeature::DIMENSION, writeRow, midPrices, sequenceLength, threshold,
+                     nullptr);
+}
 
-    if (features.size() <= sequenceLength + horizon) {
-        std::cerr << "Not enough data for sequence creation" << std::endl;
-        return;
-    }
+void FeatureExtractor::prepareLabeledData(const std::vector<OrderbookFeature>& features,
+                                          const std::vector<double>& midPrices,
+                                          ThreadPool& pool,
+                                          int sequenceLength, double threshold) {
+    auto writeRow = [&features](size_t i, double* out) { features[i].writeTo(out); };
+    buildLabeledData(features.size(), OrderbookFeature::DIMENSION, writeRow, midPrices, sequenceLength, threshold,
+                     &pool);
+}
+
+void FeatureExtractor::prepareLabeledData(const std::vector<DeployedFeatureSet::Row>& rows,
+                                          const std::vector<double>& midPrices,
+                                          double threshold) {
+    auto writeRow = [&rows](size_t i, double* out) {
+        std::copy(rows[i].values, rows[i].values + DeployedFeatureSet::WIDTH, out);
+    };
+    buildLabeledData(rows.size(), DeployedFeatureSet::WIDTH, writeRow, midPrices, MODEL_SEQ_LEN, threshold, nullptr);
+}
+
+void FeatureExtractor::prepareLabeledData(const std::vector<DeployedFeatureSet::Row>& rows,
+                                          const std::vector<double>& midPrices,
+                                          ThreadPool& pool,
+                                          double threshold) {
+    auto writeRow = [&rows](size_t i, double* out) {
+        std::copy(rows[i].values, rows[i].values + DeployedFeatureSet::WIDTH, out);
+    };
+    buildLabeledData(rows.size(), DeployedFeatureSet::WIDTH, writeRow, midPrices, MODEL_SEQ_LEN, threshold, &pool);
+}
+
+// Without a pool every stage runs inline, chunk by chunk, in order
+template <typename WriteRow>
+void FeatureExtractor::buildLabeledData(size_t numRows, size_t dim, const WriteRow& writeRow,
+                                        const std::vector<double>& midPrices,
+                                        int sequenceLength, double threshold, ThreadPool* pool) {
+    const size_t horizon = LABEL_HORIZON;
 
     featureVectors.clear();
     labels.clear();
+    sequenceDimension = 0;
 
-    // Convert all features to flat vectors
-    std::vector<std::vector<double>> allFeatureVecs;
-    for (const auto& feature : features) {
-        allFeatureVecs.push_back(feature.toVector());
+    if (sequenceLength <= 0 || numRows <= static_cast<size_t>(sequenceLength) + horizon) {
+        std::cerr << "Not enough data for sequence creation" << std::endl;
+        return;
+    }
+    if (midPrices.size() < numRows) {
+        std::cerr << "Need a mid price per feature row (" << midPrices.size() << " for " << numRows << ")"
+                  << std::endl;
+        return;
     }
 
+    auto forEachChunk = [pool](size_t count, size_t chunkSize, const auto& body) {
+        size_t numChunks = (count + chunkSize - 1) / chunkSize;
+        auto run = [&](size_t c) { body(c * chunkSize, std::min(count, (c + 1) * chunkSize)); };
+        if (pool) {
+            pool->parallelFor(numChunks, run);
+        } else {
+            for (size_t c = 0; c < numChunks; ++c) run(c);
+        }
+    };
+
+    // Convert all features into one contiguous row-major buffer
+    std::pmr::vector<double> allFeatureVecs(numRows * dim, resource);
+    const bool normalize = normalizer && normalizer->isFrozen() && normalizer->dimension() == dim;
+    forEachChunk(numRows, ROW_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            double* row = allFeatureVecs.data() + i * dim;
+            writeRow(i, row);
+            if (normalize) normalizer->apply(row);
+        }
+    });
+
     // Initialize label array with unused flag
-    std::vector<int> targetLabels(features.size(), -1);
+    std::pmr::vector<int> targetLabels(numRows, -1, resource);
 
     // Label each data point based on future price movement
-    for (size_t i = sequenceLength; i + horizon < features.size(); ++i) {
+    const size_t firstLabel = sequenceLength;
+    const size_t endLabel = numRows - horizon;
+    auto futureReturnAt = [&](size_t i) {
         double currentPrice = midPrices[i];
         double futurePrice = midPrices[i + horizon];
-        double futureReturn = (futurePrice - currentPrice) / currentPrice;
-
-        // Debug print (every 1000 samples)
-        if (i % 1000 == 0) {
-            std::cout << "[debug] futureReturn[" << i << "] = " << futureReturn << std::endl;
+        return (futurePrice - currentPrice) / currentPrice;
+    };
+    forEachChunk(endLabel - firstLabel, ROW_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = firstLabel + begin; i < firstLabel + end; ++i) {
+            double futureReturn = futureReturnAt(i);
+            if (futureReturn > threshold) {
+                targetLabels[i] = 0;  // Up
+            } else if (futureReturn < -threshold) {
+                targetLabels[i] = 1;  // Down
+            } else {
+                targetLabels[i] = 2;  // No significant change
+            }
         }
+    });
+
+    // Debug print (every 1000 samples)
+    for (size_t i = (firstLabel + 999) / 1000 * 1000; debugOutput && i < endLabel; i += 1000) {
+        std::cout << "[debug] futureReturn[" << i << "] = " << futureReturnAt(i) << std::endl;
+    }
 
-        if (futureReturn > threshold) {
-            targetLabels[i] = 0;  // Up
-        } else if (futureReturn < -threshold) {
-            targetLabels[i] = 1;  // Down
+    // Build LSTM input sequences with corresponding labels. Every window ending
+    // before the horizon has a label, so sequence i starts at row i; consecutive
+    // rows are contiguous, so each sequence is a single range copy. Chunks are
+    // streamed out in order as soon as they are complete.
+    size_t numSequences = numRows - sequenceLength - horizon;
+    sequenceDimension = sequenceLength * dim;
+    featureVectors.resize(numSequences * sequenceDimension);
+    labels.resize(numSequences);
+
+    auto copySequences = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const double* first = allFeatureVecs.data() + i * dim;
+            std::copy(first, first + sequenceDimension, featureVectors.data() + i * sequenceDimension);
+            labels[i] = targetLabels[i + sequenceLength];
+        }
+    };
+    size_t numChunks = (numSequences + SEQUENCE_CHUNK - 1) / SEQUENCE_CHUNK;
+    std::vector<std::future<void>> pending;
+    if (pool) {
+        pending.reserve(numChunks);
+        for (size_t c = 0; c < numChunks; ++c) {
+            size_t begin = c * SEQUENCE_CHUNK;
+            size_t end = std::min(numSequences, begin + SEQUENCE_CHUNK);
+            pending.push_back(pool->submit([&copySequences, begin, end]() { copySequences(begin, end); }));
+        }
+    }
+    for (size_t c = 0; c < numChunks; ++c) {
+        size_t begin = c * SEQUENCE_CHUNK;
+        size_t end = std::min(numSequences, begin + SEQUENCE_CHUNK);
+        if (pool) {
+            pending[c].get();
         } else {
-            targetLabels[i] = 2;  // No significant change
+            copySequences(begin, end);
+        }
+        if (featureStream) {
+            featureStream->write(featureVectors.data() + begin * sequenceDimension,
+                                 (end - begin) * sequenceDimension * sizeof(double));
+            labelStream->write(labels.data() + begin, (end - begin) * sizeof(int));
         }
     }
-
-    // Build LSTM input sequences with corresponding labels
-    for (size_t i = 0; i + sequenceLength + horizon < features.size(); ++i) {
-        if (targetLabels[i + sequenceLength] != -1) {
-            std::vector<double> sequence;
-
-            for (int j = 0; j < sequenceLength; ++j) {
-                const auto& vec = allFeatureVecs[i + j];
-                sequence.insert(sequence.end(), vec.begin(), vec.end());
-            }
-
-            featureVectors.push_back(sequence);
-            labels.push_back(targetLabels[i + sequenceLength]);
+    if (featureStream) {
+        if (streamedSequences > 0 && streamedDimension != sequenceDimension) {
+            std::cerr << "Sequence dimension changed mid-stream: " << streamedDimension
+                      << " vs " << sequenceDimension << std::endl;
         }
+        streamedDimension = sequenceDimension;
+        streamedSequences += labels.size();
     }
 
-    std::cout << "Created " << featureVectors.size() << " sequences with labels" << std::endl;
+    std::cout << "Created " << labels.size() << " sequences with labels" << std::endl;
 
     // Label distribution breakdown
     int up = 0, down = 0, noChange = 0;
@@ -243,44 +433,87 @@ void FeatureExtractor::prepareLabeledData(const std::vector<OrderbookFeature>& f
 
 void FeatureExtractor::saveToFiles(const std::string& featuresPath, const std::string& labelsPath) {
     // Save features
-    std::ofstream featFile(featuresPath, std::ios::binary);
-    if (!featFile) {
+    AsyncFileWriter featFile;
+    if (!featFile.open(featuresPath)) {
         std::cerr << "Failed to open features file for writing: " << featuresPath << std::endl;
         return;
     }
 
     // Write number of sequences and vector dimensions
-    size_t numSequences = featureVectors.size();
-    size_t vectorDimension = featureVectors.empty() ? 0 : featureVectors[0].size();
+    size_t numSequences = labels.size();
+    size_t vectorDimension = sequenceDimension;
 
-    featFile.write(reinterpret_cast<const char*>(&numSequences), sizeof(numSequences));
-    featFile.write(reinterpret_cast<const char*>(&vectorDimension), sizeof(vectorDimension));
+    featFile.write(&numSequences, sizeof(numSequences));
+    featFile.write(&vectorDimension, sizeof(vectorDimension));
 
     // Write feature vectors
-    for (const auto& vec : featureVectors) {
-        featFile.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(double));
-    }
+    featFile.write(featureVectors.data(), featureVectors.size() * sizeof(double));
     featFile.close();
 
     // Save labels
-    std::ofstream labelFile(labelsPath, std::ios::binary);
-    if (!labelFile) {
+    AsyncFileWriter labelFile;
+    if (!labelFile.open(labelsPath)) {
         std::cerr << "Failed to open labels file for writing: " << labelsPath << std::endl;
         return;
     }
 
     // Write number of labels
     size_t numLabels = labels.size();
-    labelFile.write(reinterpret_cast<const char*>(&numLabels), sizeof(numLabels));
+    labelFile.write(&numLabels, sizeof(numLabels));
 
     // Write labels
-    labelFile.write(reinterpret_cast<const char*>(labels.data()), labels.size() * sizeof(int));
+    labelFile.write(labels.data(), labels.size() * sizeof(int));
     labelFile.close();
 
     std::cout << "Saved " << numSequences << " sequences to " << featuresPath << std::endl;
     std::cout << "Saved " << numLabels << " labels to " << labelsPath << std::endl;
 }
 
+bool FeatureExtractor::streamToFiles(const std::string& featuresPath, const std::string& labelsPath,
+                                     const AsyncFileWriter::Config& config) {
+    if (featureStream) finishStream();
+    auto features = std::make_unique<AsyncFileWriter>();
+    auto labelsOut = std::make_unique<AsyncFileWriter>();
+    if (!features->open(featuresPath, config)) {
+        std::cerr << "Failed to open features file for writing: " << featuresPath << std::endl;
+        return false;
+    }
+    if (!labelsOut->open(labelsPath, config)) {
+        std::cerr << "Failed to open labels file for writing: " << labelsPath << std::endl;
+        return false;
+    }
+
+    // Counts are unknown until the end; finishStream() patches them in
+    size_t placeholder[2] = {0, 0};
+    features->write(placeholder, sizeof(placeholder));
+    labelsOut->write(placeholder, sizeof(size_t));
+
+    featureStream = std::move(features);
+    labelStream = std::move(labelsOut);
+    featureStreamPath = featuresPath;
+    labelStreamPath = labelsPath;
+    streamedSequences = 0;
+    streamedDimension = 0;
+    return true;
+}
+
+bool FeatureExtractor::finishStream() {
+    if (!featureStream) return false;
+    size_t header[2] = {streamedSequences, streamedDimension};
+    featureStream->patch(0, header, sizeof(header));
+    labelStream->patch(0, &streamedSequences, sizeof(size_t));
+    bool ok = featureStream->close();
+    ok = labelStream->close() && ok;
+    featureStream.reset();
+    labelStream.reset();
+
+    if (ok) {
+        std::cout << "Saved " << streamedSequences << " sequences to " << featureStreamPath << std::endl;
+        std::cout << "Saved " << streamedSequences << " labels to " << labelStreamPath << std::endl;
+    }
+    return ok;
+}
+
 // Optional: Add a method to load the saved data
 void FeatureExtractor::loadFromFiles(const std::string& featuresPath, const std::string& labelsPath) {
     // Load features
@@ -296,11 +529,9 @@ void FeatureExtractor::loadFromFiles(const std::string& featuresPath, const std:
     featFile.read(reinterpret_cast<char*>(&vectorDimension), sizeof(vectorDimension));
 
     // Resize and read feature vectors
-    featureVectors.resize(numSequences);
-    for (auto& vec : featureVectors) {
-        vec.resize(vectorDimension);
-        featFile.read(reinterpret_cast<char*>(vec.data()), vectorDimension * sizeof(double));
-    }
+    sequenceDimension = vectorDimension;
+    featureVectors.resize(numSequences * vectorDimension);
+    featFile.read(reinterpret_cast<char*>(featureVectors.data()), featureVectors.size() * sizeof(double));
     featFile.close();
 
     // Load labels
@@ -334,3 +565,45 @@ void FeatureExtractor::printLabelStats() const {
     std::cout << "  No Change = " << counts[2] << " (" << (100.0 * counts[2] / total) << "%)\n";
 }
 
+
+static void writeDeque(std::ostream& out, const std::deque<double>& values) {
+    writeBinary(out, static_cast<uint64_t>(values.size()));
+    for (double v : values) writeBinary(out, v);
+}
+
+static bool readDeque(std::istream& in, std::deque<double>& values) {
+    uint64_t size;
+    if (!readBinary(in, size)) return false;
+    values.clear();
+    for (uint64_t i = 0; i < size; ++i) {
+        double v;
+        if (!readBinary(in, v)) return false;
+        values.push_back(v);
+    }
+    return true;
+}
+
+void FeatureExtractor::writeCheckpoint(std::ostream& out) const {
+    writeBinary(out, static_cast<int32_t>(priceFeatureWindow));
+    writeBinary(out, volumeNormalization);
+    writeDeque(out, priceHistory);
+    writeDeque(out, priceChangeHistory);
+    writeDeque(out, spreadHistory);
+}
+
+bool FeatureExtractor::readCheckpoint(std::istream& in) {
+    int32_t window;
+    double normalization;
+    std::deque<double> prices, priceChanges, spreads;
+    if (!readBinary(in, window) || !readBinary(in, normalization) ||
+        !readDeque(in, prices) || !readDeque(in, priceChanges) || !readDeque(in, spreads)) {
+        return false;
+    }
+
+    priceFeatureWindow = window;
+    volumeNormalization = normalization;
+    priceHistory.swap(prices);
+    priceChangeHistory.swap(priceChanges);
+    spreadHistory.swap(spreads);
+    return true;
+}
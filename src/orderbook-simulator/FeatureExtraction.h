@@ -13,14 +13,47 @@
  * mid-price movement — essential for supervised training of LSTM-based predictors.
  *
  * These features are saved in binary format for use in model training and hardware deployment.
+ *
+ * An optional FeatureNormalizer standardizes features without a separate pass:
+ * while it is fitting, extractFeatures() feeds it every raw feature row; once it
+ * is frozen, prepareLabeledData() applies it as it writes the feature rows.
+ *
+ * The ThreadPool overloads of extractFeatures() and prepareLabeledData() split
+ * long series into chunks. The rolling windows only reach priceFeatureWindow
+ * samples back (plus the one before, which the oldest price change refers to),
+ * so each chunk replays that many preceding states before it starts emitting
+ * (the first continues from the extractor's own windows), and the result is
+ * identical to the sequential pass. A fitting normalizer gets
+ * per-chunk statistics merged in order, which matches up to rounding.
+ *
+ * Training data for the deployed model comes from the DeployedFeatureSet path
+ * instead: extractDeployedFeatures() computes the 13 registry columns
+ * (FeatureRegistry.h) event by event, and the Row overloads of
+ * prepareLabeledData() build MODEL_SEQ_LEN-row sequences, so each labeled row
+ * is MODEL_FLAT_DIM wide, as the MLP expects. That path runs sequentially:
+ * the registry's rolling sums depend on slot order, which chunk replay would
+ * change. The OrderbookFeature path is kept for the C API and research use.
+ *
+ * Output goes through AsyncFileWriter. With streamToFiles() set up beforehand,
+ * prepareLabeledData() hands each sequence and label to the writers as it builds
+ * them, and finishStream() only fills in the headers and flushes the last block.
  */
 
 #ifndef ORDERBOOK_FEATUREEXTRACTION_H
 #define ORDERBOOK_FEATUREEXTRACTION_H
 
+#include "AsyncFileWriter.h"
+#include "FeatureNormalizer.h"
+#include "FeatureRegistry.h"
 #include "Orderbook.h"
+#include "ThreadPool.h"
+#include <cstdint>
 #include <vector>
 #include <deque>
+#include <memory>
+#include <memory_resource>
+#include <istream>
+#include <ostream>
 
 struct OrderbookFeature {
     double priceChange;
@@ -40,48 +73,127 @@ struct OrderbookFeature {
     double priceTrend;
     double spreadTrend;
 
+    static constexpr int DIMENSION = 32;
+
     // For LSTM input, convert to flat array
     std::vector<double> toVector() const;
+    void writeTo(double* out) const;    // Writes DIMENSION values, no allocation
     std::vector<int> targetLabels;
 
 };
 
 class FeatureExtractor {
 public:
-    FeatureExtractor(int priceFeatureWindow = 10, double volumeNormalization = 100.0);
+    static constexpr int LABEL_HORIZON = 5;    // states between a sequence's end and its label
+    static constexpr size_t DEPLOYED_SEQUENCE_DIMENSION =
+            static_cast<size_t>(MODEL_SEQ_LEN) * DeployedFeatureSet::WIDTH;
+    static_assert(DEPLOYED_SEQUENCE_DIMENSION == MODEL_FLAT_DIM,
+                  "deployed training rows no longer match the model's FLAT_DIM");
+
+    // Sequence and label buffers are allocated from `resource` (e.g. a MemoryArena)
+    FeatureExtractor(int priceFeatureWindow = 10, double volumeNormalization = 100.0,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
-    // Extract features from a set of orderbook states
-    std::vector<OrderbookFeature> extractFeatures(const std::vector<Orderbook::State>& states);
+    // Extract features from a set of orderbook states. The rolling windows carry over from
+    // earlier calls and readCheckpoint(); call resetWindows() to start a new series.
+    std::vector<OrderbookFeature> extractFeatures(const Orderbook::History& states);
+    std::vector<OrderbookFeature> extractFeatures(const Orderbook::History& states, ThreadPool& pool);
+
+    // Empty the rolling windows of both feature paths
+    void resetWindows();
 
     // Extract single feature from current state
     OrderbookFeature extractFeature(const Orderbook::State& state);
 
-    // Create labeled data for ML
+    // Deployed feature set rows, one per state; messageTypes are LOBSTER types row-aligned
+    // with states (trade intensity stays 0 without them)
+    std::vector<DeployedFeatureSet::Row> extractDeployedFeatures(const Orderbook::History& states,
+                                                                 const std::vector<int32_t>* messageTypes = nullptr);
+
+    // Create labeled data for ML; with too few features the previous sequences and labels are cleared
+    void prepareLabeledData(const std::vector<OrderbookFeature>& features,
+                            const std::vector<double>& midPrices,
+                            int sequenceLength = 10,
+                            double threshold = 0.0005);
     void prepareLabeledData(const std::vector<OrderbookFeature>& features,
                             const std::vector<double>& midPrices,
+                            ThreadPool& pool,
                             int sequenceLength = 10,
                             double threshold = 0.0005);
+    // Sequences of MODEL_SEQ_LEN deployed rows (DEPLOYED_SEQUENCE_DIMENSION values each)
+    void prepareLabeledData(const std::vector<DeployedFeatureSet::Row>& rows,
+                            const std::vector<double>& midPrices,
+                            double threshold = 0.0005);
+    void prepareLabeledData(const std::vector<DeployedFeatureSet::Row>& rows,
+                            const std::vector<double>& midPrices,
+                            ThreadPool& pool,
+                            double threshold = 0.0005);
 
     // Save features and labels to files
     void saveToFiles(const std::string& featuresPath, const std::string& labelsPath);
 
+    // Same files, written while prepareLabeledData() runs (see header comment)
+    bool streamToFiles(const std::string& featuresPath, const std::string& labelsPath,
+                       const AsyncFileWriter::Config& config = AsyncFileWriter::Config());
+    bool finishStream();
+
     // Load features and labels from files
     void loadFromFiles(const std::string& featuresPath, const std::string& labelsPath);
 
     void printLabelStats() const;
 
+    // Print a sample of future returns while labeling; off by default (library callers)
+    void setDebugOutput(bool enabled) { debugOutput = enabled; }
+
+    // Not owned; nullptr disables normalization (the default). Its dimension picks the path it
+    // fits and applies to: OrderbookFeature::DIMENSION or DeployedFeatureSet::WIDTH
+    void setNormalizer(FeatureNormalizer* normalizer);
+
+    // Labeled sequences as one row-major [numSequences x sequenceDimension] block
+    const double* getSequenceData() const { return featureVectors.data(); }
+    size_t getNumSequences() const { return labels.size(); }
+    size_t getSequenceDimension() const { return sequenceDimension; }
+    const std::pmr::vector<int>& getLabels() const { return labels; }
+
+    // Checkpointing of the rolling windows (see Checkpoint.h)
+    void writeCheckpoint(std::ostream& out) const;
+    bool readCheckpoint(std::istream& in);
+
 private:
+    static constexpr size_t MIN_PARALLEL_CHUNK = 4096;     // states per extraction chunk
+    static constexpr size_t ROW_CHUNK = 16384;             // rows per labeling chunk
+    static constexpr size_t SEQUENCE_CHUNK = 1024;         // sequences per copy / stream chunk
+
+    // writeRow(i, out) writes row i's dim values
+    template <typename WriteRow>
+    void buildLabeledData(size_t numRows, size_t dim, const WriteRow& writeRow,
+                          const std::vector<double>& midPrices, int sequenceLength, double threshold,
+                          ThreadPool* pool);
+
     int priceFeatureWindow;
     double volumeNormalization;
+    bool debugOutput = false;
 
     // Circular buffer for calculating rolling statistics
     std::deque<double> priceHistory;
     std::deque<double> priceChangeHistory;
     std::deque<double> spreadHistory;
-
-    // For storing feature vectors and labels
-    std::vector<std::vector<double>> featureVectors;
-    std::vector<int> labels;
+    DeployedFeatureSet deployedFeatures;
+
+    // For storing feature vectors (flattened, one sequence per row) and labels
+    std::pmr::memory_resource* resource;
+    std::pmr::vector<double> featureVectors;
+    size_t sequenceDimension = 0;
+    std::pmr::vector<int> labels;
+
+    FeatureNormalizer* normalizer = nullptr;
+
+    std::unique_ptr<AsyncFileWriter> featureStream;
+    std::unique_ptr<AsyncFileWriter> labelStream;
+    std::string featureStreamPath;
+    std::string labelStreamPath;
+    size_t streamedSequences = 0;
+    size_t streamedDimension = 0;
 };
 
 #endif //ORDERBOOK_FEATUREEXTRACTION_H
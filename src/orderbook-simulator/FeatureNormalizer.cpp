@@ -0,0 +1,145 @@
+#include "FeatureNormalizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+FeatureNormalizer::FeatureNormalizer(size_t dimension)
+        : counts(dimension, 0), mean(dimension, 0.0), m2(dimension, 0.0), scale(dimension, 1.0) {
+}
+
+void FeatureNormalizer::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    std::fill(mean.begin(), mean.end(), 0.0);
+    std::fill(m2.begin(), m2.end(), 0.0);
+    std::fill(scale.begin(), scale.end(), 1.0);
+    frozen = false;
+}
+
+void FeatureNormalizer::observe(const double* row) {
+    if (frozen) return;
+    for (size_t i = 0; i < mean.size(); ++i) {
+        double x = row[i];
+        if (!std::isfinite(x)) continue;
+        uint64_t n = ++counts[i];
+        double delta = x - mean[i];
+        mean[i] += delta / static_cast<double>(n);
+        m2[i] += delta * (x - mean[i]);
+    }
+}
+
+void FeatureNormalizer::merge(const FeatureNormalizer& other) {
+    if (frozen || other.frozen) {
+        std::cerr << "Cannot merge frozen normalizer statistics" << std::endl;
+        return;
+    }
+    if (other.dimension() != dimension()) {
+        std::cerr << "Normalizer dimension mismatch: " << dimension() << " vs " << other.dimension() << std::endl;
+        return;
+    }
+    for (size_t i = 0; i < mean.size(); ++i) {
+        uint64_t na = counts[i];
+        uint64_t nb = other.counts[i];
+        if (nb == 0) continue;
+        if (na == 0) {
+            counts[i] = nb;
+            mean[i] = other.mean[i];
+            m2[i] = other.m2[i];
+            continue;
+        }
+        double n = static_cast<double>(na + nb);
+        double delta = other.mean[i] - mean[i];
+        mean[i] += delta * static_cast<double>(nb) / n;
+        m2[i] += other.m2[i] + delta * delta * static_cast<double>(na) * static_cast<double>(nb) / n;
+        counts[i] = na + nb;
+    }
+}
+
+void FeatureNormalizer::freeze() {
+    for (size_t i = 0; i < mean.size(); ++i) {
+        double variance = counts[i] > 0 ? m2[i] / static_cast<double>(counts[i]) : 0.0;
+        double stddev = std::sqrt(variance);
+        // Constant (or unseen) features pass through centred but unscaled
+        scale[i] = stddev > 10.0 * std::numeric_limits<double>::epsilon() ? stddev : 1.0;
+    }
+    frozen = true;
+}
+
+void FeatureNormalizer::apply(double* row) const {
+    for (size_t i = 0; i < mean.size(); ++i) {
+        double x = row[i];
+        row[i] = std::isfinite(x) ? (x - mean[i]) / scale[i] : 0.0;
+    }
+}
+
+bool FeatureNormalizer::saveScaler(const std::string& path) const {
+    if (!frozen) {
+        std::cerr << "Freeze the normalizer before saving " << path << std::endl;
+        return false;
+    }
+    return writeScaler(path, mean, scale);
+}
+
+bool FeatureNormalizer::loadScaler(const std::string& path) {
+    std::vector<double> newMean, newScale;
+    if (!readScaler(path, newMean, newScale)) return false;
+    if (dimension() != 0 && newMean.size() != dimension()) {
+        std::cerr << "Scaler " << path << " has " << newMean.size() << " features, expected "
+                  << dimension() << std::endl;
+        return false;
+    }
+
+    size_t n = newMean.size();
+    mean = std::move(newMean);
+    scale = std::move(newScale);
+    counts.assign(n, 0);
+    m2.assign(n, 0.0);
+    frozen = true;
+    return true;
+}
+
+bool FeatureNormalizer::writeScaler(const std::string& path, const std::vector<double>& mean,
+                                    const std::vector<double>& scale) {
+    if (mean.size() != scale.size()) {
+        std::cerr << "Scaler mean and scale differ in length" << std::endl;
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    uint32_t n = static_cast<uint32_t>(mean.size());
+    out.write("SCLR", 4);
+    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    out.write(reinterpret_cast<const char*>(mean.data()), n * sizeof(double));
+    out.write(reinterpret_cast<const char*>(scale.data()), n * sizeof(double));
+    return static_cast<bool>(out);
+}
+
+bool FeatureNormalizer::readScaler(const std::string& path, std::vector<double>& mean, std::vector<double>& scale) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    char magic[4];
+    uint32_t n = 0;
+    if (!in.read(magic, 4) || std::memcmp(magic, "SCLR", 4) != 0 ||
+        !in.read(reinterpret_cast<char*>(&n), sizeof(n))) {
+        std::cerr << "Not a scaler file: " << path << std::endl;
+        return false;
+    }
+    std::vector<double> newMean(n), newScale(n);
+    in.read(reinterpret_cast<char*>(newMean.data()), n * sizeof(double));
+    in.read(reinterpret_cast<char*>(newScale.data()), n * sizeof(double));
+    if (!in) {
+        std::cerr << "Truncated scaler file: " << path << std::endl;
+        return false;
+    }
+    mean = std::move(newMean);
+    scale = std::move(newScale);
+    return true;
+}
@@ -0,0 +1,65 @@
+/*
+ * File: FeatureNormalizer.h
+ *
+ * Description:
+ * Streaming per-feature standardization, replacing the StandardScaler pass that
+ * used to run after extraction.
+ *
+ * While fitting, observe() updates running mean and M2 with Welford's update.
+ * Normalizers filled on separate shards or threads combine exactly with merge()
+ * (Chan et al. pairwise update), so a parallel fit equals a sequential one up
+ * to rounding. freeze() turns the statistics into (mean, scale), using the
+ * population standard deviation and scale 1 for constant features, as
+ * sklearn's StandardScaler does. From then on apply() standardizes rows in
+ * place, as FeatureExtractor does when a normalizer is attached.
+ *
+ * Non-finite inputs are skipped while fitting and written as 0 (the mean) when
+ * applying. Frozen statistics are saved in the emulator's SCLR format so they
+ * plug straight into FeatureScaler / fpga_emulator --scaler; writeScaler() and
+ * readScaler() are the only SCLR reader and writer, and FeatureScaler uses
+ * them too.
+ */
+
+#ifndef ORDERBOOK_FEATURENORMALIZER_H
+#define ORDERBOOK_FEATURENORMALIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class FeatureNormalizer {
+public:
+    explicit FeatureNormalizer(size_t dimension = 0);
+
+    size_t dimension() const { return mean.size(); }
+
+    // Fitting
+    void observe(const double* row);
+    void merge(const FeatureNormalizer& other);
+    void freeze();
+    void reset();                       // back to an empty, unfrozen fit
+    bool isFrozen() const { return frozen; }
+    uint64_t count(size_t feature) const { return counts[feature]; }
+
+    // Frozen statistics
+    const std::vector<double>& getMean() const { return mean; }
+    const std::vector<double>& getScale() const { return scale; }
+    void apply(double* row) const;                              // in place
+
+    // Binary: "SCLR" | uint32 n | float64 mean[n] | float64 scale[n] (see FeatureScaler)
+    bool saveScaler(const std::string& path) const;
+    bool loadScaler(const std::string& path);                   // loads as frozen; n must match a non-zero dimension
+    static bool writeScaler(const std::string& path, const std::vector<double>& mean,
+                            const std::vector<double>& scale);
+    static bool readScaler(const std::string& path, std::vector<double>& mean, std::vector<double>& scale);
+
+private:
+    std::vector<uint64_t> counts;
+    std::vector<double> mean;
+    std::vector<double> m2;             // sum of squared deviations while fitting
+    std::vector<double> scale;          // valid once frozen
+    bool frozen = false;
+};
+
+#endif // ORDERBOOK_FEATURENORMALIZER_H
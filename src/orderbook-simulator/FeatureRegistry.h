@@ -0,0 +1,476 @@
+/*
+ * File: FeatureRegistry.h
+ *
+ * Description:
+ * Compile-time feature registry. Every feature is a small struct that declares
+ * its column NAME, its rolling WINDOW (1 for point-in-time features) and the
+ * per-event inputs it Requires (top of book, level deltas, depth totals, ...).
+ * A feature set is a type list of features:
+ *
+ *   using MySet = FeatureSet<MidPriceFeature, OfiFeature, VolatilityFeature>;
+ *
+ * FeatureSet resolves the union of required inputs (transitively, in
+ * dependency order, each input once), lays out a fixed-size POD Row with one
+ * double per feature, and computes a row in a single fused pass: inputs are
+ * updated once per event, then each selected feature reads them. Inputs and
+ * rolling windows that no selected feature needs are never instantiated, so a
+ * reduced research set costs nothing for the features it drops.
+ *
+ * DeployedFeatureSet is the 13-column set of src/data/features.py in model
+ * column order. The MODEL_* constants mirror src/model/model_mlp.py; the set's
+ * width is checked against MODEL_N_FEATURES here, FeatureExtractor's labeled
+ * rows against MODEL_FLAT_DIM, and exported weights against MODEL_FLAT_DIM
+ * when the tools load them (MlpWeights::load).
+ *
+ * Adding a feature: write the struct (NAME, WINDOW, Requires, compute) and
+ * list it in a FeatureSet. A feature may only read inputs it lists in
+ * Requires; an input may depend on other inputs the same way.
+ */
+
+#ifndef ORDERBOOK_FEATUREREGISTRY_H
+#define ORDERBOOK_FEATUREREGISTRY_H
+
+#include "Orderbook.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Shape of the deployed model (src/model/model_mlp.py: SEQ_LEN, N_FEATURES, FLAT_DIM)
+constexpr int MODEL_SEQ_LEN = 20;
+constexpr int MODEL_N_FEATURES = 13;
+constexpr int MODEL_FLAT_DIM = MODEL_SEQ_LEN * MODEL_N_FEATURES;
+
+// ---------------------------------------------------------------------------
+// Type lists
+// ---------------------------------------------------------------------------
+
+template <typename... Ts>
+struct TypeList {
+    static constexpr size_t size = sizeof...(Ts);
+};
+
+template <typename T, typename List>
+struct TypeListContains;
+
+template <typename T, typename... Ts>
+struct TypeListContains<T, TypeList<Ts...>> : std::bool_constant<(std::is_same_v<T, Ts> || ...)> {};
+
+template <typename List, typename T>
+struct TypeListAppendUnique;
+
+template <typename... Ts, typename T>
+struct TypeListAppendUnique<TypeList<Ts...>, T> {
+    using type = std::conditional_t<TypeListContains<T, TypeList<Ts...>>::value, TypeList<Ts...>, TypeList<Ts..., T>>;
+};
+
+template <typename... Lists>
+struct TypeListConcat {
+    using type = TypeList<>;
+};
+
+template <typename... Ts>
+struct TypeListConcat<TypeList<Ts...>> {
+    using type = TypeList<Ts...>;
+};
+
+template <typename... As, typename... Bs, typename... Rest>
+struct TypeListConcat<TypeList<As...>, TypeList<Bs...>, Rest...> {
+    using type = typename TypeListConcat<TypeList<As..., Bs...>, Rest...>::type;
+};
+
+// Depth-first post-order over Requires: every input lands after its own inputs
+template <typename Resolved, typename List>
+struct ResolveRequirements;
+
+template <typename Resolved, typename T>
+struct ResolveRequirement {
+    using withInputs = typename ResolveRequirements<Resolved, typename T::Requires>::type;
+    using type = typename TypeListAppendUnique<withInputs, T>::type;
+};
+
+template <typename Resolved>
+struct ResolveRequirements<Resolved, TypeList<>> {
+    using type = Resolved;
+};
+
+template <typename Resolved, typename T, typename... Rest>
+struct ResolveRequirements<Resolved, TypeList<T, Rest...>> {
+    using type = typename ResolveRequirements<typename ResolveRequirement<Resolved, T>::type, TypeList<Rest...>>::type;
+};
+
+// ---------------------------------------------------------------------------
+// Per-event inputs shared between features
+// ---------------------------------------------------------------------------
+
+struct FeatureEvent {
+    const Orderbook::State& state;
+    int messageType;        // LOBSTER message type, or -1 if unknown
+};
+
+// Fixed-size rolling window over the last N values. Sums run over the storage in
+// slot order, not arrival order, exactly as the emulator's feature stage always did.
+template <int N>
+struct RollingWindow {
+    std::array<double, N> values{};
+    int head = 0;
+    int count = 0;
+
+    void push(double v) {
+        values[head] = v;
+        head = (head + 1) % N;
+        count = std::min(count + 1, N);
+    }
+
+    double mean() const {
+        if (count == 0) return 0.0;
+        double sum = 0.0;
+        for (int i = 0; i < count; ++i) sum += values[i];
+        return sum / count;
+    }
+
+    // pandas rolling std: ddof=1, NaN (-> 0) for a single observation
+    double sampleStd() const {
+        if (count < 2) return 0.0;
+        double m = mean();
+        double sumSq = 0.0;
+        for (int i = 0; i < count; ++i) sumSq += (values[i] - m) * (values[i] - m);
+        return std::sqrt(sumSq / (count - 1));
+    }
+};
+
+inline double featureSign(double x) {
+    return (x > 0.0) - (x < 0.0);
+}
+
+struct TopOfBookInput {
+    using Requires = TypeList<>;
+
+    double mid = 0.0;
+    double spreadNorm = 0.0;
+
+    template <typename Inputs>
+    void update(const FeatureEvent& event, const Inputs&) {
+        double bestBid = event.state.bestBid.first;
+        double bestAsk = event.state.bestAsk.first;
+        mid = (bestAsk + bestBid) / 2.0;
+        spreadNorm = mid > 0.0 ? (bestAsk - bestBid) / mid : 0.0;
+    }
+};
+
+// Resting size at the first three levels and its change since the previous event
+struct LevelDeltaInput {
+    using Requires = TypeList<>;
+    static constexpr int LEVELS = 3;
+
+    double bidSize[LEVELS] = {};
+    double askSize[LEVELS] = {};
+    double dBid[LEVELS] = {};
+    double dAsk[LEVELS] = {};
+    bool first = true;
+
+    template <typename Inputs>
+    void update(const FeatureEvent& event, const Inputs&) {
+        const auto& bids = event.state.bidLevels;
+        const auto& asks = event.state.askLevels;
+        for (int i = 0; i < LEVELS; ++i) {
+            double bid = static_cast<size_t>(i) < bids.size() ? bids[i].volume : 0.0;
+            double ask = static_cast<size_t>(i) < asks.size() ? asks[i].volume : 0.0;
+            dBid[i] = first ? 0.0 : bid - bidSize[i];
+            dAsk[i] = first ? 0.0 : ask - askSize[i];
+            bidSize[i] = bid;
+            askSize[i] = ask;
+        }
+        first = false;
+    }
+
+    double levelOfi(int level) const {
+        return featureSign(dBid[level]) - featureSign(dAsk[level]);
+    }
+};
+
+struct DepthTotalsInput {
+    using Requires = TypeList<>;
+
+    double totalBid = 0.0;
+    double totalAsk = 0.0;
+
+    template <typename Inputs>
+    void update(const FeatureEvent& event, const Inputs&) {
+        totalBid = 0.0;
+        totalAsk = 0.0;
+        for (const auto& level : event.state.bidLevels) totalBid += level.volume;
+        for (const auto& level : event.state.askLevels) totalAsk += level.volume;
+    }
+};
+
+struct MidReturnInput {
+    using Requires = TypeList<TopOfBookInput>;
+
+    double midReturn = 0.0;
+    double prevLogMid = 0.0;
+    bool first = true;
+
+    template <typename Inputs>
+    void update(const FeatureEvent&, const Inputs& inputs) {
+        double mid = inputs.template get<TopOfBookInput>().mid;
+        double logMid = std::log(mid > 0.0 ? mid : 1.0);
+        midReturn = first ? 0.0 : logMid - prevLogMid;
+        prevLogMid = logMid;
+        first = false;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Features (src/data/features.py)
+// ---------------------------------------------------------------------------
+
+struct MidPriceFeature {
+    static constexpr const char* NAME = "mid_price";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<TopOfBookInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) { return inputs.template get<TopOfBookInput>().mid; }
+};
+
+struct SpreadNormFeature {
+    static constexpr const char* NAME = "spread_norm";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<TopOfBookInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) { return inputs.template get<TopOfBookInput>().spreadNorm; }
+};
+
+struct OfiFeature {
+    static constexpr const char* NAME = "ofi";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<LevelDeltaInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) { return inputs.template get<LevelDeltaInput>().levelOfi(0); }
+};
+
+struct VolumeImbalanceFeature {
+    static constexpr const char* NAME = "vol_imbalance";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<DepthTotalsInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) {
+        const auto& depth = inputs.template get<DepthTotalsInput>();
+        return (depth.totalBid - depth.totalAsk) / (depth.totalBid + depth.totalAsk + 1e-9);
+    }
+};
+
+struct DepthRatioFeature {
+    static constexpr const char* NAME = "depth_ratio";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<DepthTotalsInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) {
+        const auto& depth = inputs.template get<DepthTotalsInput>();
+        return depth.totalAsk > 0.0 ? depth.totalBid / (depth.totalAsk + 1e-9) : 1.0;
+    }
+};
+
+struct MidReturnFeature {
+    static constexpr const char* NAME = "mid_return";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<MidReturnInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) { return inputs.template get<MidReturnInput>().midReturn; }
+};
+
+struct VolatilityFeature {
+    static constexpr const char* NAME = "volatility";
+    static constexpr int WINDOW = 20;
+    using Requires = TypeList<MidReturnInput>;
+
+    RollingWindow<WINDOW> returns;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) {
+        returns.push(inputs.template get<MidReturnInput>().midReturn);
+        return returns.sampleStd();
+    }
+};
+
+struct SpreadTrendFeature {
+    static constexpr const char* NAME = "spread_trend";
+    static constexpr int WINDOW = 20;
+    using Requires = TypeList<TopOfBookInput>;
+
+    RollingWindow<WINDOW> diffs;
+    double prevSpreadNorm = 0.0;
+    bool first = true;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) {
+        double spreadNorm = inputs.template get<TopOfBookInput>().spreadNorm;
+        // spread.diff() is NaN for the first row and pandas skips it in the rolling mean
+        if (!first) diffs.push(spreadNorm - prevSpreadNorm);
+        prevSpreadNorm = spreadNorm;
+        first = false;
+        return diffs.mean();
+    }
+};
+
+struct OfiMeanFeature {
+    static constexpr const char* NAME = "ofi_ma";
+    static constexpr int WINDOW = 20;
+    using Requires = TypeList<LevelDeltaInput>;
+
+    RollingWindow<WINDOW> ofis;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) {
+        ofis.push(inputs.template get<LevelDeltaInput>().levelOfi(0));
+        return ofis.mean();
+    }
+};
+
+struct OfiLevel2Feature {
+    static constexpr const char* NAME = "ofi_l2";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<LevelDeltaInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) { return inputs.template get<LevelDeltaInput>().levelOfi(1); }
+};
+
+struct OfiLevel3Feature {
+    static constexpr const char* NAME = "ofi_l3";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<LevelDeltaInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) { return inputs.template get<LevelDeltaInput>().levelOfi(2); }
+};
+
+struct WeightedOfiFeature {
+    static constexpr const char* NAME = "weighted_ofi";
+    static constexpr int WINDOW = 1;
+    using Requires = TypeList<LevelDeltaInput>;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) {
+        const auto& levels = inputs.template get<LevelDeltaInput>();
+        return (levels.dBid[0] - levels.dAsk[0]) / (levels.bidSize[0] + levels.askSize[0] + 1e-9);
+    }
+};
+
+// Share of executions (LOBSTER types 4 and 5) among recent events; 0 without message types
+struct TradeIntensityFeature {
+    static constexpr const char* NAME = "trade_intensity";
+    static constexpr int WINDOW = 20;
+    using Requires = TypeList<>;
+
+    RollingWindow<WINDOW> trades;
+
+    template <typename Inputs>
+    double compute(const Inputs& inputs) {
+        int type = inputs.event().messageType;
+        if (type < 0) return 0.0;
+        trades.push(type == 4 || type == 5 ? 1.0 : 0.0);
+        return trades.mean();
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Feature sets
+// ---------------------------------------------------------------------------
+
+template <typename List>
+class FeatureInputs;
+
+template <typename... Inputs>
+class FeatureInputs<TypeList<Inputs...>> {
+public:
+    // Inputs are ordered so that each one's own requirements update first
+    void update(const FeatureEvent& e) {
+        current = &e;
+        (std::get<Inputs>(inputs).update(e, *this), ...);
+    }
+
+    template <typename T>
+    const T& get() const {
+        static_assert(TypeListContains<T, TypeList<Inputs...>>::value, "input not listed in any Requires");
+        return std::get<T>(inputs);
+    }
+
+    const FeatureEvent& event() const { return *current; }
+
+private:
+    std::tuple<Inputs...> inputs;
+    const FeatureEvent* current = nullptr;
+};
+
+template <typename... Features>
+class FeatureSet {
+public:
+    static_assert(sizeof...(Features) > 0, "empty feature set");
+
+    static constexpr int WIDTH = static_cast<int>(sizeof...(Features));
+    static constexpr int MAX_WINDOW = std::max({Features::WINDOW...});
+
+    using Inputs = typename ResolveRequirements<TypeList<>,
+            typename TypeListConcat<typename Features::Requires...>::type>::type;
+
+    struct Row {
+        double values[WIDTH];
+    };
+    static_assert(std::is_trivial_v<Row> && std::is_standard_layout_v<Row>, "Row must stay POD");
+
+    static constexpr std::array<const char*, WIDTH> names() { return {Features::NAME...}; }
+
+    void reset() { *this = FeatureSet(); }
+
+    // One fused pass: update the shared inputs, then every feature, NaN/inf -> 0
+    void compute(const Orderbook::State& state, int messageType, Row& row) {
+        FeatureEvent event{state, messageType};
+        inputs.update(event);
+        row = computeFeatures(std::index_sequence_for<Features...>{});
+        for (int i = 0; i < WIDTH; ++i) {
+            if (!std::isfinite(row.values[i])) row.values[i] = 0.0;
+        }
+    }
+
+private:
+    // Braced initialization evaluates left to right, and building the row as a value
+    // keeps the results out of memory that could alias feature state
+    template <size_t... I>
+    Row computeFeatures(std::index_sequence<I...>) {
+        return Row{{std::get<I>(features).compute(inputs)...}};
+    }
+
+    FeatureInputs<Inputs> inputs;
+    std::tuple<Features...> features;
+};
+
+// Column order of src/data/features.py::compute_features
+using DeployedFeatureSet = FeatureSet<
+        MidPriceFeature,
+        SpreadNormFeature,
+        OfiFeature,
+        VolumeImbalanceFeature,
+        DepthRatioFeature,
+        MidReturnFeature,
+        VolatilityFeature,
+        SpreadTrendFeature,
+        OfiMeanFeature,
+        OfiLevel2Feature,
+        OfiLevel3Feature,
+        WeightedOfiFeature,
+        TradeIntensityFeature>;
+
+static_assert(DeployedFeatureSet::WIDTH == MODEL_N_FEATURES,
+              "deployed feature set no longer matches the model's N_FEATURES");
+
+#endif // ORDERBOOK_FEATUREREGISTRY_H
@@ -0,0 +1,56 @@
+/*
+ * File: FixedPoint.h
+ *
+ * Description:
+ * Bit-accurate model of Vivado HLS ap_fixed<W, I> values as used by the hls4ml
+ * MLP (default ap_fixed<16,6>). Values are held as integers scaled by 2^(W-I).
+ *
+ * Quantization follows src/hls/quantize_sim.py exactly: truncate toward -inf,
+ * then saturate to [-2^(I-1), 2^(I-1) - 2^-(W-I)]. Products are exact (2x the
+ * fractional bits) and dot products accumulate exactly in 64 bits before a
+ * single requantization, matching the Python reference for W <= 24.
+ */
+
+#ifndef ORDERBOOK_FIXEDPOINT_H
+#define ORDERBOOK_FIXEDPOINT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+struct FixedPointFormat {
+    int width = 16;         // W: total bits
+    int integerBits = 6;    // I: integer bits including sign
+
+    int fractionalBits() const { return width - integerBits; }
+    double resolution() const { return std::ldexp(1.0, -fractionalBits()); }
+    int64_t maxRaw() const { return (int64_t(1) << (width - 1)) - 1; }
+    int64_t minRaw() const { return -(int64_t(1) << (width - 1)); }
+
+    int64_t saturate(int64_t raw) const {
+        return std::min(std::max(raw, minRaw()), maxRaw());
+    }
+
+    // double -> raw (AP_TRN + saturation)
+    int64_t quantize(double x) const {
+        if (std::isnan(x)) return 0;
+        double scaled = std::floor(std::ldexp(x, fractionalBits()));
+        if (scaled >= static_cast<double>(maxRaw())) return maxRaw();
+        if (scaled <= static_cast<double>(minRaw())) return minRaw();
+        return static_cast<int64_t>(scaled);
+    }
+
+    double toDouble(int64_t raw) const {
+        return std::ldexp(static_cast<double>(raw), -fractionalBits());
+    }
+
+    // Requantize a value with `fromFractionalBits` fractional bits (e.g. a product
+    // accumulator) into this format: arithmetic shift == floor, then saturate
+    int64_t fromWide(int64_t wide, int fromFractionalBits) const {
+        int shift = fromFractionalBits - fractionalBits();
+        int64_t raw = shift >= 0 ? (wide >> shift) : (wide * (int64_t(1) << -shift));
+        return saturate(raw);
+    }
+};
+
+#endif // ORDERBOOK_FIXEDPOINT_H
@@ -0,0 +1,610 @@
+#include "FpgaDataflowEmulator.h"
+#include "FeatureNormalizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace {
+
+template <typename T>
+bool readRaw(std::ifstream& in, T* values, size_t count) {
+    in.read(reinterpret_cast<char*>(values), count * sizeof(T));
+    return static_cast<bool>(in);
+}
+
+int ceilLog2(int n) {
+    int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    return bits;
+}
+
+template <typename T>
+int argmax(const T* values, int count) {
+    return static_cast<int>(std::max_element(values, values + count) - values);
+}
+
+// Exact intermediate of the feature kernel: products of two 48-bit raws plus headroom
+__extension__ typedef __int128 Wide;
+
+// Multiply by 2^-shift; a right shift of a signed value is floor, like AP_TRN
+Wide shiftFloor(Wide v, int shift) {
+    return shift >= 0 ? (v >> shift) : v * (Wide(1) << -shift);
+}
+
+int64_t narrow(Wide v, const FixedPointFormat& fmt) {
+    if (v > fmt.maxRaw()) return fmt.maxRaw();
+    if (v < fmt.minRaw()) return fmt.minRaw();
+    return static_cast<int64_t>(v);
+}
+
+int64_t requantize(Wide v, int fromFractionalBits, const FixedPointFormat& to) {
+    return narrow(shiftFloor(v, fromFractionalBits - to.fractionalBits()), to);
+}
+
+// floor(num / den) into `to`; x / 0 saturates by the sign of x and 0 / 0 is 0
+int64_t divide(Wide num, int numFractionalBits, Wide den, int denFractionalBits, const FixedPointFormat& to) {
+    if (den == 0) return num == 0 ? 0 : (num > 0 ? to.maxRaw() : to.minRaw());
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+    Wide scaled = shiftFloor(num, numFractionalBits - denFractionalBits - to.fractionalBits());
+    Wide q = scaled / den;
+    if (scaled % den != 0 && scaled < 0) --q;
+    return narrow(q, to);
+}
+
+Wide isqrt(Wide v) {
+    if (v <= 0) return 0;
+    unsigned __int128 x = static_cast<unsigned __int128>(v);
+    unsigned __int128 root = 0;
+    unsigned __int128 bit = static_cast<unsigned __int128>(1) << 126;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<Wide>(root);
+}
+
+// ln(x) for x > 0 with `fractionalBits`, returned with `fractionalBits`: the integer
+// part of log2 from the leading one, then one fraction bit per squaring of the
+// mantissa in [1, 2), scaled by ln 2
+Wide logFixed(Wide x, int fractionalBits) {
+    if (x <= 0) return 0;
+    const int mantissaBits = 62;
+    int msb = 0;
+    while ((x >> (msb + 1)) != 0) ++msb;
+    Wide log2 = Wide(msb - fractionalBits) << fractionalBits;
+    unsigned __int128 m = static_cast<unsigned __int128>(shiftFloor(x, msb - mantissaBits));
+    const unsigned __int128 two = static_cast<unsigned __int128>(1) << (mantissaBits + 1);
+    for (int bit = fractionalBits - 1; bit >= 0; --bit) {
+        m = (m * m) >> mantissaBits;
+        if (m >= two) {
+            m >>= 1;
+            log2 += Wide(1) << bit;
+        }
+    }
+    const Wide ln2 = 0x2C5C85FDF473DE6A;    // ln 2 * 2^62
+    return shiftFloor(log2 * ln2, mantissaBits);
+}
+
+int sign(int64_t v) {
+    return (v > 0) - (v < 0);
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Parameters
+// ---------------------------------------------------------------------------
+
+bool MlpWeights::load(const std::string& path, int inputDim) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open weights file for reading: " << path << std::endl;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t numLayers;
+    if (!readRaw(file, magic, 4) || std::memcmp(magic, "MLPW", 4) != 0 || !readRaw(file, &numLayers, 1)) {
+        std::cerr << "Not an MLPW weights file: " << path << std::endl;
+        return false;
+    }
+
+    layers.assign(numLayers, Layer());
+    for (auto& layer : layers) {
+        uint32_t outputs, inputs;
+        if (!readRaw(file, &outputs, 1) || !readRaw(file, &inputs, 1)) return false;
+        layer.outputs = outputs;
+        layer.inputs = inputs;
+        layer.weight.resize(static_cast<size_t>(outputs) * inputs);
+        layer.bias.resize(outputs);
+        if (!readRaw(file, layer.weight.data(), layer.weight.size()) ||
+            !readRaw(file, layer.bias.data(), layer.bias.size())) {
+            std::cerr << "Truncated weights file: " << path << std::endl;
+            return false;
+        }
+    }
+
+    for (size_t i = 1; i < layers.size(); ++i) {
+        if (layers[i].inputs != layers[i - 1].outputs) {
+            std::cerr << "Layer " << i << " input size does not match previous output: " << path << std::endl;
+            return false;
+        }
+    }
+    if (layers.empty()) return false;
+    if (inputDim != 0 && layers.front().inputs != inputDim) {
+        std::cerr << "Weights " << path << " take " << layers.front().inputs << " inputs, expected "
+                  << inputDim << std::endl;
+        return false;
+    }
+    return true;
+}
+
+MlpWeights MlpWeights::random(int inputDim, int hidden, int numClasses, uint32_t seed) {
+    std::mt19937 rng(seed);
+    MlpWeights weights;
+    int sizes[] = {inputDim, hidden, hidden / 2, numClasses};
+    for (int i = 0; i < 3; ++i) {
+        Layer layer;
+        layer.inputs = sizes[i];
+        layer.outputs = sizes[i + 1];
+        // Kaiming-uniform-like bound so activations stay inside ap_fixed range
+        std::uniform_real_distribution<float> dist(-1.0f / std::sqrt(float(sizes[i])),
+                                                   1.0f / std::sqrt(float(sizes[i])));
+        layer.weight.resize(static_cast<size_t>(layer.inputs) * layer.outputs);
+        layer.bias.resize(layer.outputs);
+        for (auto& w : layer.weight) w = dist(rng);
+        for (auto& b : layer.bias) b = dist(rng);
+        weights.layers.push_back(std::move(layer));
+    }
+    return weights;
+}
+
+bool FeatureScaler::load(const std::string& path, size_t width) {
+    std::vector<double> newMean, newScale;
+    if (!FeatureNormalizer::readScaler(path, newMean, newScale)) return false;
+    if (width != 0 && newMean.size() != width) {
+        std::cerr << "Scaler " << path << " has " << newMean.size() << " features, expected " << width << std::endl;
+        return false;
+    }
+    mean = std::move(newMean);
+    scale = std::move(newScale);
+    return true;
+}
+
+bool FeatureScaler::save(const std::string& path) const {
+    return FeatureNormalizer::writeScaler(path, mean, scale);
+}
+
+FeatureScaler FeatureScaler::identity(int n) {
+    FeatureScaler scaler;
+    scaler.mean.assign(n, 0.0);
+    scaler.scale.assign(n, 1.0);
+    return scaler;
+}
+
+// ---------------------------------------------------------------------------
+// Feature stage
+// ---------------------------------------------------------------------------
+
+void LobFeatureStage::reset() {
+    features.reset();
+}
+
+void LobFeatureStage::compute(const Orderbook::State& state, int messageType, double out[NUM_FEATURES]) {
+    DeployedFeatureSet::Row row;
+    features.compute(state, messageType, row);
+    std::copy(row.values, row.values + NUM_FEATURES, out);
+}
+
+void FixedLobFeatureStage::Window::push(int64_t v) {
+    values[head] = v;
+    head = (head + 1) % WINDOW;
+    count = std::min(count + 1, WINDOW);
+}
+
+int64_t FixedLobFeatureStage::Window::mean(const FixedPointFormat& fmt) const {
+    Wide sum = 0;
+    for (int i = 0; i < count; ++i) sum += values[i];
+    return divide(sum, fmt.fractionalBits(), count, 0, fmt);
+}
+
+// ddof=1 like RollingWindow, from exact sums: n*sum(v^2) - sum(v)^2 over n(n-1)
+int64_t FixedLobFeatureStage::Window::sampleStd(const FixedPointFormat& fmt) const {
+    if (count < 2) return 0;
+    Wide sum = 0, sumSq = 0;
+    for (int i = 0; i < count; ++i) {
+        sum += values[i];
+        sumSq += Wide(values[i]) * values[i];
+    }
+    Wide variance = (count * sumSq - sum * sum) / (Wide(count) * (count - 1));
+    return narrow(isqrt(variance), fmt);
+}
+
+FixedLobFeatureStage::FixedLobFeatureStage(FeatureFormats formats) : formats(formats) {
+    reset();
+}
+
+void FixedLobFeatureStage::reset() {
+    std::fill(bidSize, bidSize + LEVELS, 0);
+    std::fill(askSize, askSize + LEVELS, 0);
+    prevLogMid = 0;
+    prevSpreadNorm = 0;
+    first = true;
+    returns = Window{};
+    spreadDiffs = Window{};
+    ofis = Window{};
+    trades = Window{};
+}
+
+void FixedLobFeatureStage::compute(const Orderbook::State& state, int messageType, int64_t out[NUM_FEATURES]) {
+    const FixedPointFormat& priceFmt = formats.price;
+    const FixedPointFormat& sizeFmt = formats.size;
+    const FixedPointFormat& fmt = formats.feature;
+    const int p = priceFmt.fractionalBits();
+    const int s = sizeFmt.fractionalBits();
+    const int f = fmt.fractionalBits();
+    const int64_t one = fmt.saturate(int64_t(1) << f);
+
+    // Top of book
+    Wide bestBid = priceFmt.quantize(state.bestBid.first);
+    Wide bestAsk = priceFmt.quantize(state.bestAsk.first);
+    Wide mid = shiftFloor(bestBid + bestAsk, 1);
+    int64_t spreadNorm = mid > 0 ? divide(bestAsk - bestBid, p, mid, p, fmt) : 0;
+
+    // Level sizes and their change since the previous event
+    int64_t dBid[LEVELS], dAsk[LEVELS];
+    for (int i = 0; i < LEVELS; ++i) {
+        size_t level = static_cast<size_t>(i);
+        int64_t bid = level < state.bidLevels.size() ? sizeFmt.quantize(state.bidLevels[i].volume) : 0;
+        int64_t ask = level < state.askLevels.size() ? sizeFmt.quantize(state.askLevels[i].volume) : 0;
+        dBid[i] = first ? 0 : bid - bidSize[i];
+        dAsk[i] = first ? 0 : ask - askSize[i];
+        bidSize[i] = bid;
+        askSize[i] = ask;
+    }
+    int64_t levelOfi[LEVELS];
+    for (int i = 0; i < LEVELS; ++i) {
+        levelOfi[i] = narrow(Wide(sign(dBid[i]) - sign(dAsk[i])) << f, fmt);
+    }
+
+    Wide totalBid = 0, totalAsk = 0;
+    for (const auto& level : state.bidLevels) totalBid += sizeFmt.quantize(level.volume);
+    for (const auto& level : state.askLevels) totalAsk += sizeFmt.quantize(level.volume);
+
+    // log(mid), as MidReturnInput, evaluated at the feature format's precision
+    int64_t logMid = narrow(logFixed(shiftFloor(mid, p - f), f), fmt);
+    int64_t midReturn = first ? 0 : narrow(Wide(logMid) - prevLogMid, fmt);
+
+    returns.push(midReturn);
+    if (!first) spreadDiffs.push(spreadNorm - prevSpreadNorm);
+    ofis.push(levelOfi[0]);
+
+    out[0] = requantize(mid, p, fmt);
+    out[1] = spreadNorm;
+    out[2] = levelOfi[0];
+    out[3] = divide(totalBid - totalAsk, s, totalBid + totalAsk, s, fmt);
+    out[4] = totalAsk > 0 ? divide(totalBid, s, totalAsk, s, fmt) : one;
+    out[5] = midReturn;
+    out[6] = returns.sampleStd(fmt);
+    out[7] = spreadDiffs.mean(fmt);
+    out[8] = ofis.mean(fmt);
+    out[9] = levelOfi[1];
+    out[10] = levelOfi[2];
+    out[11] = divide(Wide(dBid[0]) - dAsk[0], s, Wide(bidSize[0]) + askSize[0], s, fmt);
+    if (messageType < 0) {
+        out[12] = 0;
+    } else {
+        trades.push(messageType == 4 || messageType == 5 ? one : 0);
+        out[12] = trades.mean(fmt);
+    }
+
+    prevLogMid = logMid;
+    prevSpreadNorm = spreadNorm;
+    first = false;
+}
+
+// ---------------------------------------------------------------------------
+// Emulator
+// ---------------------------------------------------------------------------
+
+std::vector<StageTiming> FpgaDataflowEmulator::defaultStages(const MlpWeights& weights) {
+    // hls4ml io_parallel with reuse factor 1: one multiplier per weight, so II=1 and
+    // latency = multiply + adder tree + bias/activation
+    std::vector<StageTiming> stages = {
+            {"features", 1, 8},
+            {"scale", 1, 3},
+            {"window", 1, 1},
+    };
+    for (size_t i = 0; i < weights.layers.size(); ++i) {
+        stages.push_back({"fc" + std::to_string(i + 1), 1, 2 + ceilLog2(weights.layers[i].inputs)});
+    }
+    int classes = weights.layers.empty() ? 1 : weights.layers.back().outputs;
+    stages.push_back({"argmax", 1, 1 + ceilLog2(classes)});
+    return stages;
+}
+
+FpgaDataflowEmulator::FpgaDataflowEmulator(Config config, MlpWeights weights, FeatureScaler scaler)
+        : config(std::move(config)), weights(std::move(weights)), scaler(std::move(scaler)),
+          fixedFeatureStage(this->config.featureFormats),
+          windowFixed(2 * FLAT_DIM, 0), windowFloat(2 * FLAT_DIM, 0.0) {
+    if (this->config.stages.empty()) this->config.stages = defaultStages(this->weights);
+    if (this->scaler.mean.size() != LobFeatureStage::NUM_FEATURES) {
+        std::cerr << "Scaler has " << this->scaler.mean.size() << " features, expected "
+                  << LobFeatureStage::NUM_FEATURES << "; using identity" << std::endl;
+        this->scaler = FeatureScaler::identity(LobFeatureStage::NUM_FEATURES);
+    }
+    if (this->weights.layers.empty() || this->weights.layers.front().inputs != FLAT_DIM) {
+        std::cerr << "MLP input size does not match SEQ_LEN * NUM_FEATURES; using random weights" << std::endl;
+        this->weights = MlpWeights::random(FLAT_DIM, 64, 4);
+    }
+
+    // The kernel's scaler subtracts a quantized mean and multiplies by a quantized 1/scale
+    const FeatureFormats& ports = this->config.featureFormats;
+    for (int i = 0; i < LobFeatureStage::NUM_FEATURES; ++i) {
+        scalerMean[i] = ports.feature.quantize(this->scaler.mean[i]);
+        scalerInvScale[i] = ports.coefficient.quantize(1.0 / this->scaler.scale[i]);
+    }
+
+    // Weights and biases are quantized once, exactly like quantize_sim.run_fixed_point
+    const FixedPointFormat& fmt = this->config.format;
+    int widest = FLAT_DIM;
+    for (const auto& layer : this->weights.layers) {
+        FixedLayer fixed{layer.inputs, layer.outputs, {}, {}};
+        fixed.weight.reserve(layer.weight.size());
+        for (float w : layer.weight) fixed.weight.push_back(fmt.quantize(w));
+        for (float b : layer.bias) fixed.bias.push_back(fmt.quantize(b));
+        fixedLayers.push_back(std::move(fixed));
+        widest = std::max(widest, layer.outputs);
+    }
+    for (int k = 0; k < 2; ++k) {
+        fixedActivations[k].assign(widest, 0);
+        floatActivations[k].assign(widest, 0.0);
+    }
+
+    size_t numStages = this->config.stages.size();
+    recentStarts.resize(numStages);
+    busyCycles.assign(numStages, 0);
+    stallCycles.assign(numStages, 0);
+}
+
+void FpgaDataflowEmulator::push(const Orderbook::State& state, double timestampSec, int messageType) {
+    double features[LobFeatureStage::NUM_FEATURES];
+    int64_t fixedFeatures[LobFeatureStage::NUM_FEATURES];
+    featureStage.compute(state, messageType, features);
+    fixedFeatureStage.compute(state, messageType, fixedFeatures);
+    runFunctional(features, fixedFeatures);
+    runTiming(timestampSec);
+}
+
+void FpgaDataflowEmulator::runFunctional(const double features[LobFeatureStage::NUM_FEATURES],
+                                         const int64_t fixedFeatures[LobFeatureStage::NUM_FEATURES]) {
+    const FixedPointFormat& fmt = config.format;
+    const FixedPointFormat& featureFmt = config.featureFormats.feature;
+    const int numFeatures = LobFeatureStage::NUM_FEATURES;
+    const int productFrac = featureFmt.fractionalBits() + config.featureFormats.coefficient.fractionalBits();
+
+    // Append at the tail of the slice and its mirror, then advance the head one timestep
+    int tail = windowHead;
+    for (int i = 0; i < numFeatures; ++i) {
+        maxFeatureError[i] = std::max(maxFeatureError[i], std::abs(featureFmt.toDouble(fixedFeatures[i]) - features[i]));
+
+        // Training feeds float32 after StandardScaler, so the reference rounds through float
+        float scaled = static_cast<float>((features[i] - scaler.mean[i]) / scaler.scale[i]);
+        int64_t quantized;
+        if (config.fixedFeatures) {
+            Wide centered = Wide(fixedFeatures[i]) - scalerMean[i];
+            quantized = requantize(centered * scalerInvScale[i], productFrac, fmt);
+        } else {
+            quantized = fmt.quantize(scaled);
+        }
+        windowFixed[tail + i] = quantized;
+        windowFixed[tail + FLAT_DIM + i] = quantized;
+        windowFloat[tail + i] = scaled;
+        windowFloat[tail + FLAT_DIM + i] = scaled;
+    }
+    windowHead = (windowHead + numFeatures) % FLAT_DIM;
+    if (filled < SEQ_LEN) ++filled;
+    if (filled < SEQ_LEN) return;
+
+    // Fixed-point path: exact integer dot products, one requantization per output
+    const int64_t* x = windowFixed.data() + windowHead;
+    const int frac = fmt.fractionalBits();
+    for (size_t l = 0; l < fixedLayers.size(); ++l) {
+        const FixedLayer& layer = fixedLayers[l];
+        bool relu = l + 1 < fixedLayers.size();
+        int64_t* y = fixedActivations[l % 2].data();
+        for (int o = 0; o < layer.outputs; ++o) {
+            const int64_t* w = layer.weight.data() + static_cast<size_t>(o) * layer.inputs;
+            int64_t acc = layer.bias[o] * (int64_t(1) << frac);
+            for (int i = 0; i < layer.inputs; ++i) acc += w[i] * x[i];
+            int64_t v = fmt.fromWide(acc, 2 * frac);
+            y[o] = relu ? std::max<int64_t>(v, 0) : v;
+        }
+        x = y;
+    }
+
+    // Float reference
+    const double* xf = windowFloat.data() + windowHead;
+    for (size_t l = 0; l < weights.layers.size(); ++l) {
+        const MlpWeights::Layer& layer = weights.layers[l];
+        bool relu = l + 1 < weights.layers.size();
+        double* y = floatActivations[l % 2].data();
+        for (int o = 0; o < layer.outputs; ++o) {
+            const float* w = layer.weight.data() + static_cast<size_t>(o) * layer.inputs;
+            double acc = layer.bias[o];
+            for (int i = 0; i < layer.inputs; ++i) acc += w[i] * xf[i];
+            y[o] = relu ? std::max(acc, 0.0) : acc;
+        }
+        xf = y;
+    }
+
+    const int classes = fixedLayers.back().outputs;
+    int fixedClass = argmax(x, classes);
+    int floatClass = argmax(xf, classes);
+    predictions.push_back(fixedClass);
+    if (fixedClass == floatClass) ++agreements;
+    for (int i = 0; i < classes; ++i) {
+        maxLogitError = std::max(maxLogitError, std::abs(fmt.toDouble(x[i]) - xf[i]));
+    }
+}
+
+void FpgaDataflowEmulator::runTiming(double timestampSec) {
+    const auto& stages = config.stages;
+    const size_t numStages = stages.size();
+    const size_t depth = std::max(config.fifoDepth, 1);
+    const double cyclesPerSec = config.clockMHz * 1e6;
+
+    if (tokens == 0) firstTimestamp = timestampSec;
+
+    uint64_t arrival;
+    if (config.saturate) {
+        // Offer the next token the moment the first stage can take it
+        arrival = recentStarts[0].empty() ? 0 : recentStarts[0].back() + stages[0].initiationInterval;
+    } else {
+        arrival = static_cast<uint64_t>(std::llround(std::max(timestampSec - firstTimestamp, 0.0) * cyclesPerSec));
+    }
+    if (tokens == 0) firstArrival = arrival;
+
+    uint64_t ready = arrival;
+    uint64_t firstStart = 0;
+    for (size_t k = 0; k < numStages; ++k) {
+        uint64_t earliest = ready;
+        if (!recentStarts[k].empty()) {
+            earliest = std::max(earliest, recentStarts[k].back() + stages[k].initiationInterval);
+        }
+
+        // Output FIFO full until the token `depth` places ahead has entered the next stage
+        uint64_t start = earliest;
+        if (k + 1 < numStages && recentStarts[k + 1].size() == depth) {
+            uint64_t drained = recentStarts[k + 1].front();
+            if (drained > start + stages[k].latency) start = drained - stages[k].latency;
+        }
+
+        stallCycles[k] += start - earliest;
+        busyCycles[k] += stages[k].initiationInterval;
+        recentStarts[k].push_back(start);
+        if (recentStarts[k].size() > depth) recentStarts[k].pop_front();
+
+        if (k == 0) firstStart = start;
+        ready = start + stages[k].latency;
+    }
+
+    // Tokens that have arrived but not yet been accepted by the first stage
+    while (!inputBacklog.empty() && inputBacklog.front() <= arrival) inputBacklog.pop_front();
+    maxInputBacklog = std::max(maxInputBacklog, inputBacklog.size() + (firstStart > arrival ? 1 : 0));
+    inputBacklog.push_back(firstStart);
+
+    latencies.push_back(ready - arrival);
+    lastCompletion = std::max(lastCompletion, ready);
+    ++tokens;
+}
+
+FpgaDataflowEmulator::Report FpgaDataflowEmulator::report() const {
+    Report r;
+    r.tokens = tokens;
+    r.inferences = predictions.size();
+    r.maxInputBacklog = maxInputBacklog;
+    r.maxLogitError = maxLogitError;
+    r.maxFeatureError = maxFeatureError;
+    r.classAgreement = predictions.empty() ? 0.0 : 100.0 * agreements / predictions.size();
+    if (tokens == 0) return r;
+
+    const double nsPerCycle = 1e3 / config.clockMHz;
+    r.spanCycles = lastCompletion - firstArrival;
+    r.throughputPerSec = r.spanCycles ? tokens * config.clockMHz * 1e6 / r.spanCycles : 0.0;
+
+    std::vector<uint64_t> sorted(latencies);
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (uint64_t l : sorted) sum += l;
+    r.latencyMinNs = sorted.front() * nsPerCycle;
+    r.latencyMaxNs = sorted.back() * nsPerCycle;
+    r.latencyMeanNs = sum / sorted.size() * nsPerCycle;
+    r.latencyP50Ns = sorted[sorted.size() / 2] * nsPerCycle;
+    r.latencyP99Ns = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)] * nsPerCycle;
+
+    // A stage limits the stream if it stalls its upstream without being stalled itself;
+    // without stalls, only a single saturated stage is called out (equal II=1 stages tie)
+    size_t worst = 0, busiest = 0, saturated = 0;
+    for (size_t k = 0; k < config.stages.size(); ++k) {
+        StageReport s;
+        s.timing = config.stages[k];
+        s.busyCycles = busyCycles[k];
+        s.stallCycles = stallCycles[k];
+        s.backPressure = k == 0 ? 0 : stallCycles[k - 1];
+        s.utilization = r.spanCycles ? std::min(1.0, double(busyCycles[k]) / r.spanCycles) : 0.0;
+        r.stages.push_back(s);
+    }
+    for (size_t k = 0; k < r.stages.size(); ++k) {
+        bool source = r.stages[k].stallCycles == 0;
+        if (source && r.stages[k].backPressure > r.stages[worst].backPressure) worst = k;
+        if (r.stages[k].utilization > r.stages[busiest].utilization) busiest = k;
+    }
+    for (const auto& s : r.stages) {
+        if (s.utilization >= SATURATED_UTILIZATION && s.utilization == r.stages[busiest].utilization) ++saturated;
+    }
+
+    if (!r.stages.empty() && r.stages[worst].backPressure > 0) {
+        r.bottleneck = r.stages[worst].timing.name;
+    } else if (saturated == 1) {
+        r.bottleneck = r.stages[busiest].timing.name;
+    } else {
+        r.bottleneck = "none";
+    }
+    return r;
+}
+
+void FpgaDataflowEmulator::printReport(std::ostream& out) const {
+    Report r = report();
+    const auto& fmt = config.format;
+    int maxII = 1;
+    for (const auto& s : config.stages) maxII = std::max(maxII, s.initiationInterval);
+
+    const auto& featureFmt = config.featureFormats.feature;
+    out << "--- FPGA dataflow emulation (ap_fixed<" << fmt.width << "," << fmt.integerBits << ">, "
+        << (config.fixedFeatures ? "features ap_fixed<" + std::to_string(featureFmt.width) + "," +
+                                           std::to_string(featureFmt.integerBits) + ">"
+                                 : std::string("double features"))
+        << ", " << config.clockMHz << " MHz, FIFO depth " << config.fifoDepth << ") ---\n";
+    out << "Tokens: " << r.tokens << "  Inferences: " << r.inferences << "\n";
+    out << "Throughput: " << std::fixed << std::setprecision(0) << r.throughputPerSec << " events/s observed"
+        << " (peak " << config.clockMHz * 1e6 / maxII << " at II=" << maxII << ")\n";
+    out << std::setprecision(1)
+        << "Latency ns: min " << r.latencyMinNs << "  mean " << r.latencyMeanNs
+        << "  p50 " << r.latencyP50Ns << "  p99 " << r.latencyP99Ns << "  max " << r.latencyMaxNs << "\n";
+    out << "Max input backlog: " << r.maxInputBacklog << " events\n";
+    out << std::setprecision(2) << "Fixed vs float class agreement: " << r.classAgreement
+        << "%  max logit error: " << std::setprecision(4) << r.maxLogitError << "\n";
+    const auto names = DeployedFeatureSet::names();
+    size_t worstFeature = std::max_element(r.maxFeatureError.begin(), r.maxFeatureError.end()) -
+                          r.maxFeatureError.begin();
+    out << std::scientific << std::setprecision(2) << "Max feature error (kernel vs double): "
+        << names[worstFeature] << " " << r.maxFeatureError[worstFeature] << "\n" << std::fixed;
+
+    out << std::left << std::setw(10) << "Stage" << std::right << std::setw(5) << "II"
+        << std::setw(8) << "Lat" << std::setw(10) << "Util%" << std::setw(14) << "Stall cyc"
+        << std::setw(14) << "Backpressure" << "\n";
+    for (const auto& s : r.stages) {
+        out << std::left << std::setw(10) << s.timing.name << std::right
+            << std::setw(5) << s.timing.initiationInterval
+            << std::setw(8) << s.timing.latency
+            << std::setw(10) << std::setprecision(1) << 100.0 * s.utilization
+            << std::setw(14) << s.stallCycles
+            << std::setw(14) << s.backPressure << "\n";
+    }
+    out << "Bottleneck: " << r.bottleneck << std::endl;
+    out << std::defaultfloat;
+}
@@ -0,0 +1,247 @@
+/*
+ * File: FpgaDataflowEmulator.h
+ *
+ * Description:
+ * Streaming, bit-accurate C++ model of the planned FPGA inference path:
+ *
+ *   book event -> features (13, as src/data/features.py) -> scale + quantize
+ *              -> SEQ_LEN=20 shift-register window -> fc1/ReLU -> fc2/ReLU -> fc3 -> argmax
+ *
+ * Functionally, the whole path is integer arithmetic. Book prices and sizes enter
+ * the feature kernel in fixed point (FeatureFormats, each format configurable),
+ * features are computed with exact integer products, floor divisions and an
+ * integer square root, and the scaler multiplies by a quantized 1/scale. From
+ * the scaler onward values are ap_fixed<W,I> (FixedPoint.h), and the MLP matches
+ * src/hls/quantize_sim.py bit for bit given the same inputs. A double feature
+ * stage and float MLP run alongside as the reference: the report gives the
+ * worst per-feature error of the kernel and the end-to-end class agreement.
+ * Config::fixedFeatures = false feeds the MLP from the double features instead,
+ * quantized at the stage boundary, to separate feature error from MLP error.
+ *
+ * Timing: each stage has an initiation interval (II) and latency in clock cycles,
+ * and stages are joined by bounded FIFOs. Events enter at their timestamps
+ * converted to cycles (or back-to-back in saturate mode), and the emulator
+ * tracks when every token starts each stage, including back-pressure stalls.
+ * The report gives sustained throughput, end-to-end latency percentiles and a
+ * per-stage breakdown that points at the bottleneck before synthesis: the stage
+ * whose full input FIFO stalls the stage before it while it is not stalled
+ * itself (stalls propagate upstream from it), else a single stage at >= 95%
+ * utilization, else "none" (latency-bound, or every stage equally saturated).
+ */
+
+#ifndef ORDERBOOK_FPGADATAFLOWEMULATOR_H
+#define ORDERBOOK_FPGADATAFLOWEMULATOR_H
+
+#include "FeatureRegistry.h"
+#include "FixedPoint.h"
+#include "Orderbook.h"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Float MLP parameters in torch layout (weight is [out][in] row-major)
+struct MlpWeights {
+    struct Layer {
+        int inputs = 0;
+        int outputs = 0;
+        std::vector<float> weight;
+        std::vector<float> bias;
+    };
+    std::vector<Layer> layers;
+
+    // Binary: "MLPW" | uint32 numLayers | per layer: uint32 out, uint32 in, float32 W[out*in], float32 b[out]
+    // A non-zero inputDim rejects weights whose first layer takes a different input size.
+    bool load(const std::string& path, int inputDim = 0);
+    // Deterministic random weights of the deployed shape, for timing-only runs
+    static MlpWeights random(int inputDim, int hidden, int numClasses, uint32_t seed = 42);
+};
+
+// Per-feature standardization applied before quantization: (x - mean) / scale
+struct FeatureScaler {
+    std::vector<double> mean;
+    std::vector<double> scale;
+
+    // Binary: "SCLR" | uint32 n | float64 mean[n] | float64 scale[n], read and written by FeatureNormalizer.
+    // A non-zero width rejects a file with a different number of features.
+    bool load(const std::string& path, size_t width = 0);
+    bool save(const std::string& path) const;
+    static FeatureScaler identity(int n);
+};
+
+// Streaming equivalent of src/data/features.py::compute_features (DeployedFeatureSet)
+class LobFeatureStage {
+public:
+    static constexpr int NUM_FEATURES = DeployedFeatureSet::WIDTH;
+    static constexpr int WINDOW = DeployedFeatureSet::MAX_WINDOW;
+
+    void reset();
+
+    // messageType: LOBSTER message type of the event, or -1 if unknown (trade_intensity = 0)
+    void compute(const Orderbook::State& state, int messageType, double out[NUM_FEATURES]);
+
+private:
+    DeployedFeatureSet features;
+};
+
+// Fixed-point formats of the feature kernel's ports
+struct FeatureFormats {
+    FixedPointFormat price{48, 20};     // book prices in
+    FixedPointFormat size{48, 32};      // resting sizes in
+    FixedPointFormat feature{48, 16};   // computed features out
+    FixedPointFormat coefficient{48, 24};   // scaler mean/(1/scale)
+};
+
+// LobFeatureStage in integer arithmetic, as the HLS feature kernel computes it.
+// Intermediates are exact 128-bit integers, every ratio is a floor division and
+// the rolling std an integer square root and mid_return a difference of
+// bitwise integer logarithms. Outputs are raw values in formats.feature, or
+// saturate there.
+class FixedLobFeatureStage {
+public:
+    static constexpr int NUM_FEATURES = LobFeatureStage::NUM_FEATURES;
+    static constexpr int WINDOW = LobFeatureStage::WINDOW;
+    static constexpr int LEVELS = 3;
+
+    explicit FixedLobFeatureStage(FeatureFormats formats = FeatureFormats());
+
+    void reset();
+    void compute(const Orderbook::State& state, int messageType, int64_t out[NUM_FEATURES]);
+
+    const FeatureFormats& getFormats() const { return formats; }
+
+private:
+    struct Window {
+        int64_t values[WINDOW];
+        int head;
+        int count;
+
+        void push(int64_t v);
+        int64_t mean(const FixedPointFormat& fmt) const;
+        int64_t sampleStd(const FixedPointFormat& fmt) const;
+    };
+
+    FeatureFormats formats;
+    int64_t bidSize[LEVELS];
+    int64_t askSize[LEVELS];
+    int64_t prevLogMid;
+    int64_t prevSpreadNorm;
+    bool first;
+    Window returns;
+    Window spreadDiffs;
+    Window ofis;
+    Window trades;
+};
+
+struct StageTiming {
+    std::string name;
+    int initiationInterval = 1;
+    int latency = 1;
+};
+
+class FpgaDataflowEmulator {
+public:
+    static constexpr int SEQ_LEN = MODEL_SEQ_LEN;
+
+    struct Config {
+        FixedPointFormat format;
+        FeatureFormats featureFormats;
+        bool fixedFeatures = true;  // false: quantize the double features at the scaler
+        double clockMHz = 200.0;
+        int fifoDepth = 2;          // tokens buffered between consecutive stages
+        bool saturate = false;      // ignore timestamps, feed back-to-back
+        std::vector<StageTiming> stages;   // empty = defaults from the MLP shape
+    };
+
+    struct StageReport {
+        StageTiming timing;
+        uint64_t busyCycles = 0;
+        uint64_t stallCycles = 0;   // cycles a ready token waited on a full downstream FIFO
+        uint64_t backPressure = 0;  // stall cycles this stage caused the stage before it
+        double utilization = 0.0;
+    };
+
+    struct Report {
+        uint64_t tokens = 0;
+        uint64_t inferences = 0;
+        uint64_t spanCycles = 0;
+        double throughputPerSec = 0.0;
+        double latencyMinNs = 0.0;
+        double latencyMeanNs = 0.0;
+        double latencyP50Ns = 0.0;
+        double latencyP99Ns = 0.0;
+        double latencyMaxNs = 0.0;
+        size_t maxInputBacklog = 0;
+        double classAgreement = 0.0;    // fixed vs float argmax, over inferences
+        double maxLogitError = 0.0;
+        std::array<double, LobFeatureStage::NUM_FEATURES> maxFeatureError{};    // fixed kernel vs double
+        std::vector<StageReport> stages;
+        std::string bottleneck;         // "none" if nothing limits the stream
+    };
+
+    static constexpr double SATURATED_UTILIZATION = 0.95;
+
+    FpgaDataflowEmulator(Config config, MlpWeights weights, FeatureScaler scaler);
+
+    // Stream one book event; timestampSec is the event time (ignored when saturating)
+    void push(const Orderbook::State& state, double timestampSec, int messageType = -1);
+
+    Report report() const;
+    void printReport(std::ostream& out) const;
+
+    const std::vector<int>& getPredictions() const { return predictions; }
+    static std::vector<StageTiming> defaultStages(const MlpWeights& weights);
+
+private:
+    struct FixedLayer {
+        int inputs;
+        int outputs;
+        std::vector<int64_t> weight;
+        std::vector<int64_t> bias;
+    };
+
+    static constexpr int FLAT_DIM = SEQ_LEN * LobFeatureStage::NUM_FEATURES;
+
+    void runFunctional(const double features[LobFeatureStage::NUM_FEATURES],
+                       const int64_t fixedFeatures[LobFeatureStage::NUM_FEATURES]);
+    void runTiming(double timestampSec);
+
+    Config config;
+    MlpWeights weights;
+    FeatureScaler scaler;
+    std::vector<FixedLayer> fixedLayers;
+    LobFeatureStage featureStage;
+    FixedLobFeatureStage fixedFeatureStage;
+    int64_t scalerMean[LobFeatureStage::NUM_FEATURES];      // featureFormats.feature
+    int64_t scalerInvScale[LobFeatureStage::NUM_FEATURES];  // featureFormats.coefficient
+
+    // Shift-register window, fixed and float copy. Each timestep is written twice,
+    // FLAT_DIM apart, so the current window is the contiguous slice at windowHead.
+    std::vector<int64_t> windowFixed;
+    std::vector<double> windowFloat;
+    int windowHead = 0;
+    int filled = 0;
+    std::vector<int64_t> fixedActivations[2];
+    std::vector<double> floatActivations[2];
+
+    std::vector<int> predictions;
+    uint64_t agreements = 0;
+    double maxLogitError = 0.0;
+    std::array<double, LobFeatureStage::NUM_FEATURES> maxFeatureError{};
+
+    // Timing state: per stage, start cycle of the most recent tokens (enough for FIFO depth)
+    std::vector<std::deque<uint64_t>> recentStarts;
+    std::vector<uint64_t> busyCycles;
+    std::vector<uint64_t> stallCycles;
+    std::deque<uint64_t> inputBacklog;
+    size_t maxInputBacklog = 0;
+    std::vector<uint64_t> latencies;
+    uint64_t tokens = 0;
+    uint64_t firstArrival = 0;
+    uint64_t lastCompletion = 0;
+    double firstTimestamp = 0.0;
+};
+
+#endif // ORDERBOOK_FPGADATAFLOWEMULATOR_H
@@ -0,0 +1,107 @@
+/*
+ * File: LatencyHistogram.h
+ *
+ * Description:
+ * Fixed-memory log-linear latency histogram in nanoseconds. Each power-of-two
+ * range is split into SUB_BUCKETS linear buckets, so any recorded value is
+ * reported within 1/SUB_BUCKETS (~3%) of its true value over the whole
+ * uint64 range, with a constant-time record() that never allocates.
+ */
+
+#ifndef ORDERBOOK_LATENCYHISTOGRAM_H
+#define ORDERBOOK_LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t nanos) {
+        ++counts[bucketOf(nanos)];
+        ++total;
+        sum += nanos;
+        minValue = std::min(minValue, nanos);
+        maxValue = std::max(maxValue, nanos);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < NUM_BUCKETS; ++i) counts[i] += other.counts[i];
+        total += other.total;
+        sum += other.sum;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    // Upper edge of the bucket holding the q-quantile, clamped to the exact max
+    uint64_t percentile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * (total - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucketUpper(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    void print(std::ostream& out, const std::string& label) const {
+        out << std::left << std::setw(14) << label << std::right
+            << " n=" << total
+            << "  min=" << min()
+            << "  p50=" << percentile(0.50)
+            << "  p90=" << percentile(0.90)
+            << "  p99=" << percentile(0.99)
+            << "  p99.9=" << percentile(0.999)
+            << "  p99.99=" << percentile(0.9999)
+            << "  max=" << max() << " ns" << std::endl;
+    }
+
+    // One "upper_ns,count" row per non-empty bucket
+    void writeCsv(std::ostream& out) const {
+        out << "upper_ns,count\n";
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            if (counts[i]) out << bucketUpper(i) << "," << counts[i] << "\n";
+        }
+    }
+
+private:
+    // Values below SUB_BUCKETS map linearly; above, the top SUB_BUCKET_BITS+1
+    // significant bits select the bucket
+    static int bucketOf(uint64_t v) {
+        if (v < static_cast<uint64_t>(SUB_BUCKETS)) return static_cast<int>(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - SUB_BUCKET_BITS;
+        int sub = static_cast<int>((v >> shift) & (SUB_BUCKETS - 1));
+        return (shift + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t bucketUpper(int index) {
+        if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+        return ((static_cast<uint64_t>(SUB_BUCKETS) + sub + 1) << shift) - 1;
+    }
+
+    std::array<uint64_t, NUM_BUCKETS> counts{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t minValue = UINT64_MAX;
+    uint64_t maxValue = 0;
+};
+
+#endif // ORDERBOOK_LATENCYHISTOGRAM_H
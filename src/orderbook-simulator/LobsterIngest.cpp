@@ -0,0 +1,374 @@
+#include "LobsterIngest.h"
+#include "ThreadPool.h"
+#include "ZipArchive.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+namespace {
+
+constexpr double PRICE_SCALE = 10000.0;
+constexpr int64_t DUMMY_PRICE_LIMIT = 9000000000LL;
+
+// Byte range of whole lines in an inflated CSV, and where its rows land in the columns
+struct Chunk {
+    size_t begin;
+    size_t end;
+    size_t firstRow;
+    size_t rows;
+};
+
+// Per-archive work state shared across the pipeline stages
+struct ArchiveJob {
+    LobsterDay* day;
+    std::unique_ptr<ZipArchive> zip;
+    std::string messageText;
+    std::string bookText;
+    std::vector<Chunk> messageChunks;
+    std::vector<Chunk> bookChunks;
+    std::atomic<bool> failed{false};
+};
+
+std::vector<Chunk> splitLines(const std::string& text, size_t chunkBytes) {
+    std::vector<Chunk> chunks;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = std::min(pos + chunkBytes, text.size());
+        if (end < text.size()) {
+            const void* nl = std::memchr(text.data() + end, '\n', text.size() - end);
+            end = nl ? static_cast<const char*>(nl) - text.data() + 1 : text.size();
+        }
+        chunks.push_back({pos, end, 0, 0});
+        pos = end;
+    }
+    return chunks;
+}
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Rows are the lines with any content, so blank (e.g. trailing) lines are not counted
+size_t countLines(const std::string& text, const Chunk& chunk) {
+    const char* p = text.data() + chunk.begin;
+    const char* end = text.data() + chunk.end;
+    size_t lines = 0;
+    bool content = false;
+    for (; p < end; ++p) {
+        if (*p == '\n') {
+            lines += content;
+            content = false;
+        } else if (!isBlank(*p)) {
+            content = true;
+        }
+    }
+    return lines + content;  // last line without newline
+}
+
+size_t assignRows(std::vector<Chunk>& chunks) {
+    size_t total = 0;
+    for (auto& chunk : chunks) {
+        chunk.firstRow = total;
+        total += chunk.rows;
+    }
+    return total;
+}
+
+double toDollars(int64_t raw) {
+    if (raw >= DUMMY_PRICE_LIMIT || raw <= -DUMMY_PRICE_LIMIT) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return raw / PRICE_SCALE;
+}
+
+// Parse one comma-separated field and step past the separator
+template <typename T>
+bool parseField(const char*& p, const char* end, T& value) {
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    if (p < end && *p == ',') ++p;
+    return true;
+}
+
+// Steps over line ends and blank lines, matching what countLines() does not count
+void skipLineEnd(const char*& p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+}
+
+bool parseMessageChunk(const std::string& text, const Chunk& chunk, LobsterMessages& out) {
+    const char* p = text.data() + chunk.begin;
+    const char* end = text.data() + chunk.end;
+    for (size_t row = chunk.firstRow; row < chunk.firstRow + chunk.rows; ++row) {
+        skipLineEnd(p, end);
+        int64_t price, orderId;
+        int32_t type, size, direction;
+        if (!parseField(p, end, out.time[row]) || !parseField(p, end, type) ||
+            !parseField(p, end, orderId) || !parseField(p, end, size) ||
+            !parseField(p, end, price) || !parseField(p, end, direction)) {
+            return false;
+        }
+        out.type[row] = type;
+        out.orderId[row] = orderId;
+        out.size[row] = size;
+        out.price[row] = price / PRICE_SCALE;
+        out.direction[row] = static_cast<int8_t>(direction);
+        skipLineEnd(p, end);
+    }
+    return true;
+}
+
+// Row layout: AskP1,AskS1,BidP1,BidS1, AskP2,AskS2,BidP2,BidS2, ...
+bool parseBookChunk(const std::string& text, const Chunk& chunk, LobsterBook& out) {
+    const char* p = text.data() + chunk.begin;
+    const char* end = text.data() + chunk.end;
+    for (size_t row = chunk.firstRow; row < chunk.firstRow + chunk.rows; ++row) {
+        skipLineEnd(p, end);
+        for (int level = 0; level < out.levels; ++level) {
+            int64_t askPrice, askSize, bidPrice, bidSize;
+            if (!parseField(p, end, askPrice) || !parseField(p, end, askSize) ||
+                !parseField(p, end, bidPrice) || !parseField(p, end, bidSize)) {
+                return false;
+            }
+            out.askPrice[level][row] = toDollars(askPrice);
+            out.askSize[level][row] = static_cast<double>(askSize);
+            out.bidPrice[level][row] = toDollars(bidPrice);
+            out.bidSize[level][row] = static_cast<double>(bidSize);
+        }
+        skipLineEnd(p, end);
+    }
+    return true;
+}
+
+// LOBSTER_SampleFile_<SYMBOL>_<DATE>_<LEVELS>.zip
+bool parseArchiveName(const std::string& path, LobsterDay& day) {
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    if (name.size() < 4 || name.compare(name.size() - 4, 4, ".zip") != 0) return false;
+    name.resize(name.size() - 4);
+
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (size_t pos; (pos = name.find('_', start)) != std::string::npos; start = pos + 1) {
+        parts.push_back(name.substr(start, pos - start));
+    }
+    parts.push_back(name.substr(start));
+    if (parts.size() < 5) return false;
+
+    day.symbol = parts[2];
+    day.date = parts[3];
+    day.levels = std::atoi(parts[4].c_str());
+    return day.levels > 0;
+}
+
+template <typename T>
+void writeColumn(std::ofstream& file, const std::vector<T>& column) {
+    file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+} // namespace
+
+void LobsterMessages::resize(size_t n) {
+    time.resize(n);
+    type.resize(n);
+    orderId.resize(n);
+    size.resize(n);
+    price.resize(n);
+    direction.resize(n);
+}
+
+void LobsterBook::resize(int numLevels, size_t n) {
+    levels = numLevels;
+    for (auto* side : {&askPrice, &askSize, &bidPrice, &bidSize}) {
+        side->resize(numLevels);
+        for (auto& column : *side) column.resize(n);
+    }
+}
+
+Orderbook::History LobsterDay::toHistory(int depth, std::pmr::memory_resource* resource) const {
+    Orderbook::History history(resource);
+    size_t rows = book.rows();
+    bool haveTimes = messages.rows() == rows;
+    depth = std::min(depth, book.levels);
+    history.reserve(rows);
+    double lastMid = 0.0;
+
+    for (size_t row = 0; row < rows; ++row) {
+        history.emplace_back();
+        Orderbook::State& state = history.back();
+        state.timestamp = haveTimes ? messages.time[row] : static_cast<double>(row);
+
+        // Empty levels (NaN) are skipped, matching the simulator's sparse level vectors
+        for (int level = 0; level < depth; ++level) {
+            if (!std::isnan(book.bidPrice[level][row])) {
+                state.bidLevels.push_back({book.bidPrice[level][row], book.bidSize[level][row]});
+            }
+            if (!std::isnan(book.askPrice[level][row])) {
+                state.askLevels.push_back({book.askPrice[level][row], book.askSize[level][row]});
+            }
+        }
+
+        if (!state.bidLevels.empty()) state.bestBid = {state.bidLevels[0].price, state.bidLevels[0].volume};
+        if (!state.askLevels.empty()) state.bestAsk = {state.askLevels[0].price, state.askLevels[0].volume};
+        if (state.bestBid.first > 0.0 && state.bestAsk.first > 0.0) {
+            lastMid = (state.bestBid.first + state.bestAsk.first) / 2.0;
+            state.spread = state.bestAsk.first - state.bestBid.first;
+        }
+        state.midPrice = lastMid;
+    }
+
+    return history;
+}
+
+bool LobsterDay::saveColumns(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open columns file for writing: " << path << std::endl;
+        return false;
+    }
+
+    size_t rows = messages.rows();
+    size_t numLevels = book.levels;
+    file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    file.write(reinterpret_cast<const char*>(&numLevels), sizeof(numLevels));
+
+    writeColumn(file, messages.time);
+    writeColumn(file, messages.type);
+    writeColumn(file, messages.orderId);
+    writeColumn(file, messages.size);
+    writeColumn(file, messages.price);
+    writeColumn(file, messages.direction);
+
+    for (int level = 0; level < book.levels; ++level) {
+        writeColumn(file, book.askPrice[level]);
+        writeColumn(file, book.askSize[level]);
+        writeColumn(file, book.bidPrice[level]);
+        writeColumn(file, book.bidSize[level]);
+    }
+
+    return static_cast<bool>(file);
+}
+
+std::vector<std::string> findLobsterArchives(const std::string& directory, int levels) {
+    std::vector<std::string> paths;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        std::cerr << "Failed to open directory: " << directory << std::endl;
+        return paths;
+    }
+
+    while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        LobsterDay day;
+        if (name.rfind("LOBSTER_SampleFile_", 0) != 0 || !parseArchiveName(name, day)) continue;
+        if (levels > 0 && day.levels != levels) continue;
+        paths.push_back(directory + "/" + name);
+    }
+    closedir(dir);
+
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+std::vector<LobsterDay> ingestLobsterArchives(const std::vector<std::string>& paths, ThreadPool& pool,
+                                              size_t chunkBytes) {
+    std::vector<LobsterDay> days(paths.size());
+    std::vector<std::unique_ptr<ArchiveJob>> jobs;
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        days[i].sourcePath = paths[i];
+        if (!parseArchiveName(paths[i], days[i])) {
+            std::cerr << "Not a LOBSTER sample archive name: " << paths[i] << std::endl;
+            continue;
+        }
+        auto job = std::make_unique<ArchiveJob>();
+        job->day = &days[i];
+        job->zip = std::make_unique<ZipArchive>(paths[i]);
+        if (job->zip->isOpen()) jobs.push_back(std::move(job));
+    }
+
+    // Stage 1: inflate message and orderbook members of every archive concurrently
+    std::vector<std::future<void>> pending;
+    for (auto& job : jobs) {
+        ArchiveJob* j = job.get();
+        const ZipArchive::Member* message = j->zip->find("message", ".csv");
+        const ZipArchive::Member* book = j->zip->find("orderbook", ".csv");
+        if (!message || !book) {
+            std::cerr << "Missing message/orderbook CSV in " << j->day->sourcePath << std::endl;
+            j->failed = true;
+            continue;
+        }
+        pending.push_back(pool.submit([j, message]() {
+            if (!j->zip->extract(*message, j->messageText)) j->failed = true;
+        }));
+        pending.push_back(pool.submit([j, book]() {
+            if (!j->zip->extract(*book, j->bookText)) j->failed = true;
+        }));
+    }
+    for (auto& f : pending) f.get();
+    pending.clear();
+
+    // Stage 2: cut on line boundaries and count rows per chunk
+    for (auto& job : jobs) {
+        ArchiveJob* j = job.get();
+        if (j->failed) continue;
+        j->zip.reset();
+        j->messageChunks = splitLines(j->messageText, chunkBytes);
+        j->bookChunks = splitLines(j->bookText, chunkBytes);
+        for (auto& chunk : j->messageChunks) {
+            Chunk* c = &chunk;
+            pending.push_back(pool.submit([j, c]() { c->rows = countLines(j->messageText, *c); }));
+        }
+        for (auto& chunk : j->bookChunks) {
+            Chunk* c = &chunk;
+            pending.push_back(pool.submit([j, c]() { c->rows = countLines(j->bookText, *c); }));
+        }
+    }
+    for (auto& f : pending) f.get();
+    pending.clear();
+
+    // Stage 3: size the columns once, then parse every chunk straight into its rows
+    for (auto& job : jobs) {
+        ArchiveJob* j = job.get();
+        if (j->failed) continue;
+        LobsterDay& day = *j->day;
+        day.messages.resize(assignRows(j->messageChunks));
+        day.book.resize(day.levels, assignRows(j->bookChunks));
+
+        for (const auto& chunk : j->messageChunks) {
+            const Chunk* c = &chunk;
+            pending.push_back(pool.submit([j, c]() {
+                if (!parseMessageChunk(j->messageText, *c, j->day->messages)) j->failed = true;
+            }));
+        }
+        for (const auto& chunk : j->bookChunks) {
+            const Chunk* c = &chunk;
+            pending.push_back(pool.submit([j, c]() {
+                if (!parseBookChunk(j->bookText, *c, j->day->book)) j->failed = true;
+            }));
+        }
+    }
+    for (auto& f : pending) f.get();
+
+    for (auto& job : jobs) {
+        LobsterDay& day = *job->day;
+        if (job->failed) {
+            std::cerr << "Failed to ingest " << day.sourcePath << std::endl;
+            continue;
+        }
+        if (day.messages.rows() != day.book.rows()) {
+            std::cerr << "Row count mismatch (messages=" << day.messages.rows()
+                      << ", orderbook=" << day.book.rows() << ") in " << day.sourcePath << std::endl;
+            continue;
+        }
+        day.ok = true;
+    }
+
+    return days;
+}
@@ -0,0 +1,82 @@
+/*
+ * File: LobsterIngest.h
+ *
+ * Description:
+ * Parallel bulk ingest of LOBSTER sample archives (data/raw/LOBSTER_SampleFile_*.zip)
+ * into columnar arrays — the C++ counterpart of src/data/lobster_loader.py.
+ *
+ * Each archive's message and orderbook CSVs are inflated directly from the zip,
+ * cut into chunks on line boundaries and parsed in parallel on a ThreadPool.
+ * Many symbol/date/level archives are ingested at once: every stage fans out
+ * across all files before waiting, so small archives do not leave cores idle.
+ * Inflation itself is serial per member (one task per CSV), and parsing starts
+ * once every member has inflated; a single large archive is bounded by its
+ * larger member's inflate time.
+ *
+ * Conventions follow lobster_loader.py: prices are converted from price x 10000
+ * to dollars, and the dummy prices LOBSTER uses for empty levels (+/-9999999999)
+ * become NaN.
+ */
+
+#ifndef ORDERBOOK_LOBSTERINGEST_H
+#define ORDERBOOK_LOBSTERINGEST_H
+
+#include "Orderbook.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Message file columns: Time, Type, OrderID, Size, Price, Direction
+struct LobsterMessages {
+    std::vector<double> time;
+    std::vector<int32_t> type;
+    std::vector<int64_t> orderId;
+    std::vector<int32_t> size;
+    std::vector<double> price;
+    std::vector<int8_t> direction;
+
+    size_t rows() const { return time.size(); }
+    void resize(size_t n);
+};
+
+// Orderbook file, one column per (side, field, level); index as column[level][row]
+struct LobsterBook {
+    int levels = 0;
+    std::vector<std::vector<double>> askPrice;
+    std::vector<std::vector<double>> askSize;
+    std::vector<std::vector<double>> bidPrice;
+    std::vector<std::vector<double>> bidSize;
+
+    size_t rows() const { return askPrice.empty() ? 0 : askPrice[0].size(); }
+    void resize(int numLevels, size_t n);
+};
+
+struct LobsterDay {
+    std::string symbol;
+    std::string date;
+    int levels = 0;
+    std::string sourcePath;
+    bool ok = false;
+
+    LobsterMessages messages;
+    LobsterBook book;
+
+    // Orderbook::State series (top `depth` levels, message timestamps) for FeatureExtractor.
+    // While a side is empty the spread is 0 and the mid carries the last two-sided value.
+    Orderbook::History toHistory(int depth = 5,
+                                 std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+    // Columnar binary dump: rows, levels, then each column as a raw array
+    bool saveColumns(const std::string& path) const;
+};
+
+// Find LOBSTER_SampleFile_*_<levels>.zip in `directory` (levels <= 0 matches all)
+std::vector<std::string> findLobsterArchives(const std::string& directory, int levels = 0);
+
+// Ingest all given archives; chunkBytes is the target parse chunk size
+std::vector<LobsterDay> ingestLobsterArchives(const std::vector<std::string>& paths, ThreadPool& pool,
+                                              size_t chunkBytes = 4u << 20);
+
+#endif // ORDERBOOK_LOBSTERINGEST_H
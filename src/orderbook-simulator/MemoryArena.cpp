@@ -0,0 +1,75 @@
+#include "MemoryArena.h"
+#include "Orderbook.h"
+#include <iostream>
+#include <sys/mman.h>
+
+namespace {
+
+constexpr size_t HUGE_PAGE_SIZE = 2u << 20;
+
+size_t roundUp(size_t bytes, size_t multiple) {
+    return (bytes + multiple - 1) / multiple * multiple;
+}
+
+// Map the backing region; with huge pages requested, try explicit hugetlbfs pages
+// first, then fall back to normal pages with a transparent-huge-page hint.
+void* mapRegion(size_t& size, bool& hugePages) {
+    if (size == 0) {
+        hugePages = false;
+        return nullptr;
+    }
+
+    if (hugePages) {
+        size = roundUp(size, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) return p;
+#endif
+        hugePages = false;
+    }
+
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        std::cerr << "MemoryArena: mmap of " << size << " bytes failed, using heap only" << std::endl;
+        size = 0;
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (size >= HUGE_PAGE_SIZE) madvise(p, size, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+} // namespace
+
+MemoryArena::MemoryArena(size_t initialBytes, bool useHugePages)
+        : regionSize(initialBytes),
+          hugePages(useHugePages),
+          region(mapRegion(regionSize, hugePages)),
+          monotonic(region, regionSize, std::pmr::new_delete_resource()) {
+}
+
+MemoryArena::~MemoryArena() {
+    monotonic.release();
+    if (region) munmap(region, regionSize);
+}
+
+size_t MemoryArena::bytesForEvents(size_t expectedEvents, int depth) {
+    // One State in the history vector, its two level vectors of `depth` entries,
+    // and a level-map node (erased nodes are not reused by a monotonic arena)
+    size_t perEvent = sizeof(Orderbook::State) + 2 * depth * sizeof(Orderbook::Level) + 64;
+    return expectedEvents * perEvent + (1u << 20);
+}
+
+void* MemoryArena::do_allocate(size_t bytes, size_t alignment) {
+    return monotonic.allocate(bytes, alignment);
+}
+
+void MemoryArena::do_deallocate(void*, size_t, size_t) {
+    // Monotonic: memory is reclaimed only when the arena is destroyed
+}
+
+bool MemoryArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,50 @@
+/*
+ * File: MemoryArena.h
+ *
+ * Description:
+ * A monotonic std::pmr memory resource for the long-lived, append-only buffers
+ * of the pipeline: the Orderbook level maps and snapshot history, and the
+ * FeatureExtractor's flattened feature/label buffers.
+ *
+ * The arena maps one contiguous region up front (optionally backed by huge pages)
+ * and bump-allocates out of it. Deallocation is a no-op; the whole region is
+ * returned at once when the arena is destroyed, so tearing down a multi-million
+ * snapshot history no longer costs one free() per level vector. If the region is
+ * exhausted the arena keeps growing from the global heap.
+ *
+ * The arena must outlive every Orderbook / FeatureExtractor constructed on it.
+ */
+
+#ifndef ORDERBOOK_MEMORYARENA_H
+#define ORDERBOOK_MEMORYARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+class MemoryArena : public std::pmr::memory_resource {
+public:
+    explicit MemoryArena(size_t initialBytes = 64u << 20, bool useHugePages = false);
+    ~MemoryArena() override;
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    // Rough arena size needed to hold the history of `expectedEvents` book updates
+    // at the given snapshot depth, including the history vector itself
+    static size_t bytesForEvents(size_t expectedEvents, int depth = 5);
+
+    size_t capacity() const { return regionSize; }
+    bool usingHugePages() const { return hugePages; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    size_t regionSize;
+    bool hugePages;
+    void* region;
+    std::pmr::monotonic_buffer_resource monotonic;
+};
+
+#endif // ORDERBOOK_MEMORYARENA_H
@@ -3,11 +3,87 @@
 //
 
 #include "Orderbook.h"
+#include "Checkpoint.h"
 #include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <chrono>
+#include <iterator>
 
-Orderbook::Orderbook() = default;
+namespace {
+
+constexpr const char* CSV_HEADER =
+        "timestamp,mid_price,spread,best_bid_price,best_bid_size,best_ask_price,best_ask_size"
+        ",bid_price_0,bid_size_0,bid_price_1,bid_size_1,bid_price_2,bid_size_2"
+        ",bid_price_3,bid_size_3,bid_price_4,bid_size_4"
+        ",ask_price_0,ask_size_0,ask_price_1,ask_size_1,ask_price_2,ask_size_2"
+        ",ask_price_3,ask_size_3,ask_price_4,ask_size_4\n";
+
+// 27 fields of at most 13 characters ("-1.23457e+308") plus separators
+constexpr size_t CSV_ROW_CAPACITY = 512;
+
+// Same text as `std::ostream << double` with default flags (%g, precision 6)
+char* appendNumber(char* p, char* end, double value) {
+    return std::to_chars(p, end, value, std::chars_format::general, 6).ptr;
+}
+
+char* appendLevels(char* p, char* end, const std::pmr::vector<Orderbook::Level>& levels) {
+    for (size_t i = 0; i < 5; ++i) {
+        *p++ = ',';
+        if (i < levels.size()) {
+            p = appendNumber(p, end, levels[i].price);
+            *p++ = ',';
+            p = appendNumber(p, end, levels[i].volume);
+        } else {
+            *p++ = '0';
+            *p++ = ',';
+            *p++ = '0';
+        }
+    }
+    return p;
+}
+
+void writeCsvRow(AsyncFileWriter& out, const Orderbook::State& state) {
+    char row[CSV_ROW_CAPACITY];
+    char* end = row + sizeof(row);
+    char* p = appendNumber(row, end, state.timestamp);
+    const double fields[] = {state.midPrice, state.spread, state.bestBid.first, state.bestBid.second,
+                             state.bestAsk.first, state.bestAsk.second};
+    for (double field : fields) {
+        *p++ = ',';
+        p = appendNumber(p, end, field);
+    }
+    p = appendLevels(p, end, state.bidLevels);
+    p = appendLevels(p, end, state.askLevels);
+    *p++ = '\n';
+    out.write(row, static_cast<size_t>(p - row));
+}
+
+} // namespace
+
+Orderbook::State::State(const State& other, const allocator_type& alloc)
+        : timestamp(other.timestamp),
+          midPrice(other.midPrice),
+          spread(other.spread),
+          bestBid(other.bestBid),
+          bestAsk(other.bestAsk),
+          bidLevels(other.bidLevels, alloc),
+          askLevels(other.askLevels, alloc) {
+}
+
+Orderbook::State::State(State&& other, const allocator_type& alloc)
+        : timestamp(other.timestamp),
+          midPrice(other.midPrice),
+          spread(other.spread),
+          bestBid(other.bestBid),
+          bestAsk(other.bestAsk),
+          bidLevels(std::move(other.bidLevels), alloc),
+          askLevels(std::move(other.askLevels), alloc) {
+}
+
+Orderbook::Orderbook(std::pmr::memory_resource* resource)
+        : bids(resource), asks(resource), history(resource), streamState(resource) {
+}
 
 void Orderbook::updateBid(Price price, Volume volume) {
     if (volume > 0) {
@@ -15,7 +91,7 @@ void Orderbook::updateBid(Price price, Volume volume) {
     } else {
         bids.erase(price);
     }
-    history.push_back(getCurrentState());
+    recordState();
 }
 
 void Orderbook::updateAsk(Price price, Volume volume) {
@@ -24,7 +100,7 @@ void Orderbook::updateAsk(Price price, Volume volume) {
     } else {
         asks.erase(price);
     }
-    history.push_back(getCurrentState());
+    recordState();
 }
 
 void Orderbook::clearLevel(bool isBid, Price price) {
@@ -33,7 +109,7 @@ void Orderbook::clearLevel(bool isBid, Price price) {
     } else {
         asks.erase(price);
     }
-    history.push_back(getCurrentState());
+    recordState();
 }
 
 std::pair<Price, Volume> Orderbook::getBestBid() const {
@@ -80,59 +156,147 @@ std::vector<Orderbook::Level> Orderbook::getAskLevels(int depth) const {
     return levels;
 }
 
-Orderbook::State Orderbook::getCurrentState() const {
-    auto now = std::chrono::system_clock::now();
-    double timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()).count() / 1000.0;
+Volume Orderbook::getVolumeAt(bool isBid, Price price) const {
+    if (isBid) {
+        auto it = bids.find(price);
+        return it == bids.end() ? 0.0 : it->second;
+    }
+    auto it = asks.find(price);
+    return it == asks.end() ? 0.0 : it->second;
+}
 
+bool Orderbook::getLevel(bool isBid, int index, Level& out) const {
+    if (index < 0) return false;
+    if (isBid) {
+        if (static_cast<size_t>(index) >= bids.size()) return false;
+        auto it = std::next(bids.begin(), index);
+        out = {it->first, it->second};
+        return true;
+    }
+    if (static_cast<size_t>(index) >= asks.size()) return false;
+    auto it = std::next(asks.begin(), index);
+    out = {it->first, it->second};
+    return true;
+}
+
+Orderbook::State Orderbook::getCurrentState() const {
     State state;
-    state.timestamp = timestamp;
+    fillState(state);
+    return state;
+}
+
+void Orderbook::getCurrentState(State& out) const {
+    fillState(out);
+}
+
+// Snapshot straight into the history so the level vectors are allocated from
+// the history's resource rather than copied across from the default heap
+void Orderbook::recordState() {
+    if (recordHistory) {
+        history.emplace_back();
+        fillState(history.back());
+        if (historyStream) writeCsvRow(*historyStream, history.back());
+    } else if (historyStream) {
+        fillState(streamState);
+        writeCsvRow(*historyStream, streamState);
+    }
+}
+
+void Orderbook::fillState(State& state) const {
+    if (clockTime) {
+        state.timestamp = *clockTime;
+    } else {
+        auto now = std::chrono::system_clock::now();
+        state.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now.time_since_epoch()).count() / 1000.0;
+    }
     state.midPrice = getMidPrice();
     state.spread = getSpread();
     state.bestBid = getBestBid();
     state.bestAsk = getBestAsk();
-    state.bidLevels = getBidLevels();
-    state.askLevels = getAskLevels();
 
-    return state;
+    const int depth = 5;
+    state.bidLevels.clear();
+    state.bidLevels.reserve(depth);
+    auto bidIt = bids.begin();
+    for (int i = 0; i < depth && bidIt != bids.end(); ++i, ++bidIt) {
+        state.bidLevels.push_back({bidIt->first, bidIt->second});
+    }
+
+    state.askLevels.clear();
+    state.askLevels.reserve(depth);
+    auto askIt = asks.begin();
+    for (int i = 0; i < depth && askIt != asks.end(); ++i, ++askIt) {
+        state.askLevels.push_back({askIt->first, askIt->second});
+    }
 }
 
 void Orderbook::saveHistoryToCSV(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+    AsyncFileWriter file;
+    if (!file.open(filename)) {
         std::cerr << "Error opening file: " << filename << std::endl;
         return;
     }
 
-    // CSV header
-    file << "timestamp,mid_price,spread,best_bid_price,best_bid_size,best_ask_price,best_ask_size";
-    for (int i = 0; i < 5; ++i) file << ",bid_price_" << i << ",bid_size_" << i;
-    for (int i = 0; i < 5; ++i) file << ",ask_price_" << i << ",ask_size_" << i;
-    file << '\n';
+    file.write(CSV_HEADER, std::char_traits<char>::length(CSV_HEADER));
+    for (const auto& state : history) writeCsvRow(file, state);
+    file.close();
+}
+
+bool Orderbook::streamHistoryToCSV(const std::string& filename, const AsyncFileWriter::Config& config) {
+    if (historyStream) finishHistoryStream();
+    auto stream = std::make_unique<AsyncFileWriter>();
+    if (!stream->open(filename, config)) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+    stream->write(CSV_HEADER, std::char_traits<char>::length(CSV_HEADER));
+    historyStream = std::move(stream);
+    return true;
+}
+
+bool Orderbook::finishHistoryStream() {
+    if (!historyStream) return false;
+    bool ok = historyStream->close();
+    historyStream.reset();
+    return ok;
+}
+
+void Orderbook::writeCheckpoint(std::ostream& out) const {
+    writeBinary(out, static_cast<uint64_t>(bids.size()));
+    for (const auto& level : bids) {
+        writeBinary(out, level.first);
+        writeBinary(out, level.second);
+    }
 
-    for (const auto& state : history) {
-        file << state.timestamp << "," << state.midPrice << "," << state.spread << ","
-             << state.bestBid.first << "," << state.bestBid.second << ","
-             << state.bestAsk.first << "," << state.bestAsk.second;
+    writeBinary(out, static_cast<uint64_t>(asks.size()));
+    for (const auto& level : asks) {
+        writeBinary(out, level.first);
+        writeBinary(out, level.second);
+    }
+}
 
-        for (int i = 0; i < 5; ++i) {
-            if (i < state.bidLevels.size()) {
-                file << "," << state.bidLevels[i].price << "," << state.bidLevels[i].volume;
-            } else {
-                file << ",0,0";
-            }
-        }
+bool Orderbook::readCheckpoint(std::istream& in) {
+    uint64_t count;
+    Price price;
+    Volume volume;
 
-        for (int i = 0; i < 5; ++i) {
-            if (i < state.askLevels.size()) {
-                file << "," << state.askLevels[i].price << "," << state.askLevels[i].volume;
-            } else {
-                file << ",0,0";
-            }
-        }
+    // Levels are written in map order, so hinted insertion at end() is O(1) each
+    decltype(bids) newBids(bids.get_allocator());
+    if (!readBinary(in, count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!readBinary(in, price) || !readBinary(in, volume)) return false;
+        newBids.emplace_hint(newBids.end(), price, volume);
+    }
 
-        file << '\n';
+    decltype(asks) newAsks(asks.get_allocator());
+    if (!readBinary(in, count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!readBinary(in, price) || !readBinary(in, volume)) return false;
+        newAsks.emplace_hint(newAsks.end(), price, volume);
     }
 
-    file.close();
+    bids.swap(newBids);
+    asks.swap(newAsks);
+    return true;
 }
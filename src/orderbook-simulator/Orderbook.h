@@ -8,23 +8,38 @@
  * update, clear, and query order book states at multiple price levels.
  *
  * Each update creates a time-stamped snapshot of the book, which includes
- * the top bid/ask levels, spread, and mid-price. These snapshots are stored
+ * the top bid/ask levels, spread, and mid-price. Snapshots carry the wall-clock
+ * time (ms resolution) unless a driver sets the book's clock with setTime(),
+ * as OrderbookSimulator does with its own clock. These snapshots are stored
  * as a time-series history and can be exported for analysis or used to
  * extract machine learning features.
  *
  * The order book supports real-time simulation and is designed to interact
  * with the OrderbookSimulator and FeatureExtractor components to create
  * labeled training data for FPGA-deployable LSTM networks.
+ *
+ * All containers (level maps, history and each snapshot's level vectors) are
+ * std::pmr and draw from the memory resource passed at construction, so the
+ * book can be placed on a MemoryArena instead of the global heap.
+ *
+ * A book is move-only: while streaming its history it owns the open
+ * AsyncFileWriter (see streamHistoryToCSV).
  */
 
 #ifndef ORDERBOOK_ORDERBOOK_H
 #define ORDERBOOK_ORDERBOOK_H
 
+#include "AsyncFileWriter.h"
 #include <map>
+#include <memory>
+#include <optional>
 #include <vector>
+#include <memory_resource>
 #include <string>
 #include <fstream>
 #include <functional>
+#include <istream>
+#include <ostream>
 
 using Price = double;
 using Volume = double;
@@ -37,16 +52,35 @@ public:
     };
 
     struct State {
-        double timestamp;
-        Price midPrice;
-        Price spread;
-        std::pair<Price, Volume> bestBid;
-        std::pair<Price, Volume> bestAsk;
-        std::vector<Level> bidLevels;
-        std::vector<Level> askLevels;
+        // Allocator-aware so snapshots stored in a pmr history allocate their
+        // level vectors from the history's resource
+        using allocator_type = std::pmr::polymorphic_allocator<Level>;
+
+        double timestamp = 0.0;
+        Price midPrice = 0.0;
+        Price spread = 0.0;
+        std::pair<Price, Volume> bestBid{};
+        std::pair<Price, Volume> bestAsk{};
+        std::pmr::vector<Level> bidLevels;
+        std::pmr::vector<Level> askLevels;
+
+        State() = default;
+        explicit State(const allocator_type& alloc) : bidLevels(alloc), askLevels(alloc) {}
+        State(const State& other, const allocator_type& alloc);
+        State(State&& other, const allocator_type& alloc);
+        State(const State&) = default;
+        State(State&&) = default;
+        State& operator=(const State&) = default;
+        State& operator=(State&&) = default;
     };
 
-    Orderbook();
+    using History = std::pmr::vector<State>;
+
+    explicit Orderbook(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    Orderbook(const Orderbook&) = delete;
+    Orderbook& operator=(const Orderbook&) = delete;
+    Orderbook(Orderbook&&) = default;
+    Orderbook& operator=(Orderbook&&) = default;
 
     // Order updates
     void updateBid(Price price, Volume volume);
@@ -60,16 +94,40 @@ public:
     Price getSpread() const;
     std::vector<Level> getBidLevels(int depth = 5) const;
     std::vector<Level> getAskLevels(int depth = 5) const;
+    Volume getVolumeAt(bool isBid, Price price) const;          // 0 if the level is empty
+    bool getLevel(bool isBid, int index, Level& out) const;     // index 0 = best; false past the last level
     State getCurrentState() const;
+    void getCurrentState(State& out) const;   // Reuses out's level capacity
+
+    // Stamp later snapshots with this time (seconds since the epoch) instead of the wall clock
+    void setTime(double timestampSec) { clockTime = timestampSec; }
 
     // History
-    const std::vector<State>& getHistory() const { return history; }
+    const History& getHistory() const { return history; }
+    void reserveHistory(size_t expectedEvents) { history.reserve(expectedEvents); }
+    void setRecordHistory(bool enabled) { recordHistory = enabled; }   // Off for latency-critical replay
     void saveHistoryToCSV(const std::string& filename) const;
+    // Append each snapshot to a CSV as it is recorded (even with history recording off),
+    // so the disk keeps pace with generation; finishHistoryStream() flushes the tail
+    bool streamHistoryToCSV(const std::string& filename,
+                            const AsyncFileWriter::Config& config = AsyncFileWriter::Config());
+    bool finishHistoryStream();
+
+    // Checkpointing (live levels only, see Checkpoint.h)
+    void writeCheckpoint(std::ostream& out) const;
+    bool readCheckpoint(std::istream& in);
 
 private:
-    std::map<Price, Volume, std::greater<Price>> bids;
-    std::map<Price, Volume> asks;
-    std::vector<State> history;
+    void recordState();
+    void fillState(State& state) const;
+
+    std::pmr::map<Price, Volume, std::greater<Price>> bids;
+    std::pmr::map<Price, Volume> asks;
+    History history;
+    bool recordHistory = true;
+    std::optional<double> clockTime;    // unset: wall clock
+    std::unique_ptr<AsyncFileWriter> historyStream;
+    State streamState;                  // scratch snapshot when streaming without history
 };
 
 #endif // ORDERBOOK_ORDERBOOK_H
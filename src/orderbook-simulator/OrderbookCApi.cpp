@@ -0,0 +1,300 @@
+#include "orderbook_c.h"
+#include "Orderbook.h"
+#include "OrderbookSimulator.h"
+#include "FeatureExtraction.h"
+#include <exception>
+#include <string>
+#include <vector>
+
+// ob_book / ob_simulator are the C++ objects themselves behind opaque pointers;
+// the extractor handle also keeps the last extraction for labeling.
+struct ob_extractor {
+    FeatureExtractor extractor;
+    std::vector<OrderbookFeature> features;
+    std::vector<double> midPrices;
+
+    ob_extractor(int window, double volumeNormalization) : extractor(window, volumeNormalization) {}
+};
+
+struct ob_array {
+    std::vector<double> values;
+    int64_t rows;
+    int64_t cols;
+};
+
+namespace {
+
+constexpr int HISTORY_DEPTH = 5;
+constexpr int HISTORY_COLUMNS = 7 + 4 * HISTORY_DEPTH;
+
+thread_local std::string lastError;
+
+Orderbook* toBook(ob_book* book) { return reinterpret_cast<Orderbook*>(book); }
+const Orderbook* toBook(const ob_book* book) { return reinterpret_cast<const Orderbook*>(book); }
+OrderbookSimulator* toSimulator(ob_simulator* sim) { return reinterpret_cast<OrderbookSimulator*>(sim); }
+
+void setError(const char* where, const std::exception& e) {
+    lastError = std::string(where) + ": " + e.what();
+}
+
+void setError(const char* where, const char* message) {
+    lastError = std::string(where) + ": " + message;
+}
+
+bool checkHandle(const void* handle, const char* where) {
+    if (!handle) setError(where, "null handle");
+    return handle != nullptr;
+}
+
+ob_buffer makeBuffer(const void* data, int64_t rows, int64_t cols, int32_t ndim, ob_dtype dtype) {
+    ob_buffer buffer;
+    buffer.data = const_cast<void*>(data);
+    buffer.shape[0] = rows;
+    buffer.shape[1] = cols;
+    buffer.ndim = ndim;
+    buffer.dtype = dtype;
+    return buffer;
+}
+
+ob_buffer emptyBuffer() {
+    return makeBuffer(nullptr, 0, 0, 0, OB_DTYPE_FLOAT64);
+}
+
+} // namespace
+
+extern "C" {
+
+int32_t ob_abi_version(void) {
+    return OB_ABI_VERSION;
+}
+
+const char* ob_last_error(void) {
+    return lastError.c_str();
+}
+
+ob_book* ob_book_create(void) {
+    try {
+        return reinterpret_cast<ob_book*>(new Orderbook());
+    } catch (const std::exception& e) {
+        setError("ob_book_create", e);
+        return nullptr;
+    }
+}
+
+void ob_book_destroy(ob_book* book) {
+    delete toBook(book);
+}
+
+void ob_book_update_bid(ob_book* book, double price, double volume) {
+    if (!checkHandle(book, "ob_book_update_bid")) return;
+    try {
+        toBook(book)->updateBid(price, volume);
+    } catch (const std::exception& e) {
+        setError("ob_book_update_bid", e);
+    }
+}
+
+void ob_book_update_ask(ob_book* book, double price, double volume) {
+    if (!checkHandle(book, "ob_book_update_ask")) return;
+    try {
+        toBook(book)->updateAsk(price, volume);
+    } catch (const std::exception& e) {
+        setError("ob_book_update_ask", e);
+    }
+}
+
+void ob_book_clear_level(ob_book* book, int32_t is_bid, double price) {
+    if (!checkHandle(book, "ob_book_clear_level")) return;
+    try {
+        toBook(book)->clearLevel(is_bid != 0, price);
+    } catch (const std::exception& e) {
+        setError("ob_book_clear_level", e);
+    }
+}
+
+int32_t ob_book_apply_updates(ob_book* book, const int8_t* is_bid, const double* prices,
+                              const double* volumes, int64_t n) {
+    if (!book || (n > 0 && (!is_bid || !prices || !volumes))) {
+        setError("ob_book_apply_updates", "null argument");
+        return -1;
+    }
+    try {
+        Orderbook* ob = toBook(book);
+        for (int64_t i = 0; i < n; ++i) {
+            if (is_bid[i]) {
+                ob->updateBid(prices[i], volumes[i]);
+            } else {
+                ob->updateAsk(prices[i], volumes[i]);
+            }
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        setError("ob_book_apply_updates", e);
+        return -1;
+    }
+}
+
+double ob_book_mid_price(const ob_book* book) {
+    if (!checkHandle(book, "ob_book_mid_price")) return 0.0;
+    return toBook(book)->getMidPrice();
+}
+
+double ob_book_spread(const ob_book* book) {
+    if (!checkHandle(book, "ob_book_spread")) return 0.0;
+    return toBook(book)->getSpread();
+}
+
+int64_t ob_book_history_size(const ob_book* book) {
+    if (!checkHandle(book, "ob_book_history_size")) return -1;
+    return static_cast<int64_t>(toBook(book)->getHistory().size());
+}
+
+ob_array* ob_book_history(const ob_book* book) {
+    if (!checkHandle(book, "ob_book_history")) return nullptr;
+    try {
+        const auto& history = toBook(book)->getHistory();
+        auto* array = new ob_array{std::vector<double>(history.size() * HISTORY_COLUMNS, 0.0),
+                                   static_cast<int64_t>(history.size()), HISTORY_COLUMNS};
+
+        double* row = array->values.data();
+        for (const auto& state : history) {
+            row[0] = state.timestamp;
+            row[1] = state.midPrice;
+            row[2] = state.spread;
+            row[3] = state.bestBid.first;
+            row[4] = state.bestBid.second;
+            row[5] = state.bestAsk.first;
+            row[6] = state.bestAsk.second;
+            for (int i = 0; i < HISTORY_DEPTH && i < (int)state.bidLevels.size(); ++i) {
+                row[7 + 2 * i] = state.bidLevels[i].price;
+                row[8 + 2 * i] = state.bidLevels[i].volume;
+            }
+            for (int i = 0; i < HISTORY_DEPTH && i < (int)state.askLevels.size(); ++i) {
+                row[7 + 2 * HISTORY_DEPTH + 2 * i] = state.askLevels[i].price;
+                row[8 + 2 * HISTORY_DEPTH + 2 * i] = state.askLevels[i].volume;
+            }
+            row += HISTORY_COLUMNS;
+        }
+        return array;
+    } catch (const std::exception& e) {
+        setError("ob_book_history", e);
+        return nullptr;
+    }
+}
+
+ob_simulator* ob_simulator_create(double initial_price, double tick_size,
+                                  int32_t levels, double volatility, uint64_t seed) {
+    try {
+        return reinterpret_cast<ob_simulator*>(new OrderbookSimulator(
+                initial_price, tick_size, levels, volatility, std::pmr::get_default_resource(), seed));
+    } catch (const std::exception& e) {
+        setError("ob_simulator_create", e);
+        return nullptr;
+    }
+}
+
+void ob_simulator_destroy(ob_simulator* simulator) {
+    delete toSimulator(simulator);
+}
+
+int32_t ob_simulator_step(ob_simulator* simulator, int64_t ticks, double event_probability) {
+    if (!checkHandle(simulator, "ob_simulator_step")) return -1;
+    try {
+        OrderbookSimulator* sim = toSimulator(simulator);
+        for (int64_t i = 0; i < ticks; ++i) sim->step(event_probability, OrderbookSimulator::DEFAULT_TICK_MS);
+        return 0;
+    } catch (const std::exception& e) {
+        setError("ob_simulator_step", e);
+        return -1;
+    }
+}
+
+ob_book* ob_simulator_book(ob_simulator* simulator) {
+    if (!checkHandle(simulator, "ob_simulator_book")) return nullptr;
+    return reinterpret_cast<ob_book*>(&toSimulator(simulator)->getOrderbook());
+}
+
+ob_extractor* ob_extractor_create(int32_t price_feature_window, double volume_normalization) {
+    try {
+        return new ob_extractor(price_feature_window, volume_normalization);
+    } catch (const std::exception& e) {
+        setError("ob_extractor_create", e);
+        return nullptr;
+    }
+}
+
+void ob_extractor_destroy(ob_extractor* extractor) {
+    delete extractor;
+}
+
+ob_array* ob_extractor_extract(ob_extractor* extractor, const ob_book* book) {
+    if (!checkHandle(extractor, "ob_extractor_extract") || !checkHandle(book, "ob_extractor_extract")) {
+        return nullptr;
+    }
+    try {
+        const auto& history = toBook(book)->getHistory();
+        extractor->extractor.resetWindows();
+        extractor->features = extractor->extractor.extractFeatures(history);
+
+        extractor->midPrices.clear();
+        extractor->midPrices.reserve(history.size());
+        for (const auto& state : history) extractor->midPrices.push_back(state.midPrice);
+
+        const int dim = OrderbookFeature::DIMENSION;
+        auto* array = new ob_array{std::vector<double>(extractor->features.size() * dim),
+                                   static_cast<int64_t>(extractor->features.size()), dim};
+        for (size_t i = 0; i < extractor->features.size(); ++i) {
+            extractor->features[i].writeTo(array->values.data() + i * dim);
+        }
+        return array;
+    } catch (const std::exception& e) {
+        setError("ob_extractor_extract", e);
+        return nullptr;
+    }
+}
+
+int64_t ob_extractor_label(ob_extractor* extractor, int32_t sequence_length, double threshold) {
+    if (!checkHandle(extractor, "ob_extractor_label")) return -1;
+    if (sequence_length <= 0) {
+        setError("ob_extractor_label", "sequence_length must be positive");
+        return -1;
+    }
+    try {
+        // Runs even when too short, so the previous call's sequences are not left behind
+        extractor->extractor.prepareLabeledData(extractor->features, extractor->midPrices,
+                                                sequence_length, threshold);
+        if (extractor->features.size() <= static_cast<size_t>(sequence_length) + FeatureExtractor::LABEL_HORIZON) {
+            setError("ob_extractor_label", "not enough extracted states for one sequence plus the label horizon");
+            return -1;
+        }
+        return static_cast<int64_t>(extractor->extractor.getNumSequences());
+    } catch (const std::exception& e) {
+        setError("ob_extractor_label", e);
+        return -1;
+    }
+}
+
+ob_buffer ob_extractor_sequences(const ob_extractor* extractor) {
+    if (!extractor) return emptyBuffer();
+    const FeatureExtractor& fx = extractor->extractor;
+    return makeBuffer(fx.getSequenceData(), static_cast<int64_t>(fx.getNumSequences()),
+                      static_cast<int64_t>(fx.getSequenceDimension()), 2, OB_DTYPE_FLOAT64);
+}
+
+ob_buffer ob_extractor_labels(const ob_extractor* extractor) {
+    if (!extractor) return emptyBuffer();
+    const auto& labels = extractor->extractor.getLabels();
+    static_assert(sizeof(int) == sizeof(int32_t), "labels are exported as int32");
+    return makeBuffer(labels.data(), static_cast<int64_t>(labels.size()), 1, 1, OB_DTYPE_INT32);
+}
+
+ob_buffer ob_array_buffer(const ob_array* array) {
+    if (!array) return emptyBuffer();
+    return makeBuffer(array->values.data(), array->rows, array->cols, 2, OB_DTYPE_FLOAT64);
+}
+
+void ob_array_destroy(ob_array* array) {
+    delete array;
+}
+
+} // extern "C"
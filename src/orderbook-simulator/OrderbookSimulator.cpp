@@ -3,28 +3,42 @@
  */
 
 #include "OrderbookSimulator.h"
+#include "Checkpoint.h"
+#include <algorithm>
+#include <sstream>
 #include <thread>
 #include <iostream>
 #include <cmath>
 
 OrderbookSimulator::OrderbookSimulator(double initialPrice, double tickSize,
-                                       int levels, double volatility)
-        : currentPrice(initialPrice),
+                                       int levels, double volatility,
+                                       std::pmr::memory_resource* resource,
+                                       std::optional<uint64_t> seed)
+        : orderbook(resource),
+          currentPrice(initialPrice),
           tickSize(tickSize),
           numLevels(levels),
           volatility(volatility),
-          normalDist(0.0, volatility) {
-    std::random_device rd;
-    rng.seed(rd());
+          normalDist(0.0, volatility),
+          unitDist(0.0, 1.0) {
+    if (seed) {
+        std::seed_seq seq{static_cast<uint32_t>(*seed), static_cast<uint32_t>(*seed >> 32)};
+        rng.seed(seq);
+    } else {
+        std::random_device rd;
+        rng.seed(rd());
+    }
 
     lastUpdateTime = std::chrono::system_clock::now();
+    arrivalEpoch = lastUpdateTime;
+    setBookTime(lastUpdateTime);
 
     for (int i = 1; i <= numLevels; ++i) {
         double bidPrice = currentPrice - i * tickSize;
         double askPrice = currentPrice + i * tickSize;
 
-        double baseBidSize = 10.0 * (1.0 + 0.5 * static_cast<double>(rand()) / RAND_MAX) / (1.0 + 0.2 * i);
-        double baseAskSize = 10.0 * (1.0 + 0.5 * static_cast<double>(rand()) / RAND_MAX) / (1.0 + 0.2 * i);
+        double baseBidSize = randomBaseSize(i);
+        double baseAskSize = randomBaseSize(i);
 
         orderbook.updateBid(bidPrice, baseBidSize);
         orderbook.updateAsk(askPrice, baseAskSize);
@@ -32,11 +46,15 @@ OrderbookSimulator::OrderbookSimulator(double initialPrice, double tickSize,
 }
 
 void OrderbookSimulator::generateUpdate() {
-    auto currentTime = std::chrono::system_clock::now();
-    double timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
-            currentTime - lastUpdateTime).count() / 1000.0;
+    updateAt(std::chrono::system_clock::now());
+}
+
+void OrderbookSimulator::updateAt(std::chrono::time_point<std::chrono::system_clock> currentTime) {
+    double timeDelta = std::max(0.0, std::chrono::duration<double>(currentTime - lastUpdateTime).count());
 
     lastUpdateTime = currentTime;
+    setBookTime(currentTime);
+    applyDueUpdates(currentTime);
 
     // Changed this
     std::uniform_real_distribution<double> uniform_dist(0.0, 1.0);
@@ -49,8 +67,8 @@ void OrderbookSimulator::generateUpdate() {
         double bidPrice = currentPrice - i * tickSize;
         double askPrice = currentPrice + i * tickSize;
 
-        double baseBidSize = 10.0 * (1.0 + 0.5 * static_cast<double>(rand()) / RAND_MAX) / (1.0 + 0.2 * i);
-        double baseAskSize = 10.0 * (1.0 + 0.5 * static_cast<double>(rand()) / RAND_MAX) / (1.0 + 0.2 * i);
+        double baseBidSize = randomBaseSize(i);
+        double baseAskSize = randomBaseSize(i);
 
         orderbook.updateBid(bidPrice, baseBidSize);
         orderbook.updateAsk(askPrice, baseAskSize);
@@ -138,11 +156,9 @@ void OrderbookSimulator::simulateRandomEvent() {
                 // Place spoof order
                 orderbook.updateAsk(spoofPrice, spoofSize);
 
-                // Schedule removal after short delay
-                std::thread([=, this]() {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                    orderbook.updateAsk(spoofPrice, askLevels[level].volume);  // Revert to original
-                }).detach();
+                // Schedule removal after short delay (revert to original size)
+                pendingUpdates.push_back({lastUpdateTime + std::chrono::milliseconds(50),
+                                          false, spoofPrice, askLevels[level].volume});
             }
             break;
 
@@ -176,6 +192,21 @@ void OrderbookSimulator::simulateRandomEvent() {
     }
 }
 
+void OrderbookSimulator::step(double eventProbability, double dtMs) {
+    auto dt = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::duration<double, std::milli>(std::max(dtMs, 0.0)));
+    stepAt(lastUpdateTime + dt, eventProbability);
+}
+
+void OrderbookSimulator::stepAt(std::chrono::time_point<std::chrono::system_clock> now, double eventProbability) {
+    updateAt(now);
+    ++ticks;
+
+    if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < eventProbability) {
+        simulateRandomEvent();
+    }
+}
+
 void OrderbookSimulator::runSimulation(int durationSeconds, int updatesPerSecond) {
     std::cout << "Starting orderbook simulation for " << durationSeconds << " seconds..." << std::endl;
 
@@ -191,11 +222,7 @@ void OrderbookSimulator::runSimulation(int durationSeconds, int updatesPerSecond
         auto currentTime = std::chrono::system_clock::now();
 
         if (currentTime >= nextUpdateTime) {
-            generateUpdate();
-
-            if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < 0.2) {
-                simulateRandomEvent();
-            }
+            stepAt(currentTime, 0.2);
 
             ++updateCount;
             if (updateCount % 100 == 0) {
@@ -224,3 +251,231 @@ void OrderbookSimulator::runSimulation(int durationSeconds, int updatesPerSecond
 Orderbook& OrderbookSimulator::getOrderbook() {
     return orderbook;
 }
+
+void OrderbookSimulator::setArrivalModel(std::unique_ptr<ArrivalModel> model) {
+    arrivalModel = std::move(model);
+    if (arrivalModel) arrivalModel->reset();
+    arrivalEpoch = lastUpdateTime;
+    arrivalRandom.reseed((static_cast<uint64_t>(rng()) << 32) | rng());
+    arrivalCounts.fill(0);
+}
+
+ArrivalEvent OrderbookSimulator::generateEvent() {
+    if (!arrivalModel) {
+        ArrivalModel::Rates rates;
+        rates.fill(1.0);
+        setArrivalModel(std::make_unique<PoissonArrivalModel>(rates));
+    }
+
+    ArrivalEvent event = arrivalModel->next(arrivalRandom);
+    setBookTime(arrivalEpoch, event.time);
+    Orderbook::Level level{};
+
+    switch (event.type) {
+        case OrderEventType::LimitBid:
+        case OrderEventType::LimitAsk: {
+            // Join the touch or rest a few ticks behind it
+            bool isBid = event.type == OrderEventType::LimitBid;
+            Price touch = orderbook.getLevel(isBid, 0, level) ? level.price
+                                                              : currentPrice + (isBid ? -tickSize : tickSize);
+            int offset = drawLevelOffset();
+            Price price = snapToTick(touch + (isBid ? -offset : offset) * tickSize);
+            if (price <= 0.0) break;
+            Volume size = 10.0 * (0.5 + arrivalRandom.uniform()) / (1.0 + 0.2 * offset);
+            Volume volume = orderbook.getVolumeAt(isBid, price) + size;
+            if (isBid) orderbook.updateBid(price, volume);
+            else orderbook.updateAsk(price, volume);
+            break;
+        }
+
+        case OrderEventType::CancelBid:
+        case OrderEventType::CancelAsk: {
+            bool isBid = event.type == OrderEventType::CancelBid;
+            if (!orderbook.getLevel(isBid, drawLevelOffset(), level) && !orderbook.getLevel(isBid, 0, level)) break;
+            Volume remaining = level.volume - 4.0 * arrivalRandom.exponential();
+            Volume volume = remaining > 0.01 ? remaining : 0.0;
+            if (isBid) orderbook.updateBid(level.price, volume);
+            else orderbook.updateAsk(level.price, volume);
+            break;
+        }
+
+        case OrderEventType::MarketBuy:
+        case OrderEventType::MarketSell: {
+            // Walk the opposite side until the order is filled
+            bool hitBids = event.type == OrderEventType::MarketSell;
+            Volume remaining = 8.0 * arrivalRandom.exponential();
+            while (remaining > 0.0 && orderbook.getLevel(hitBids, 0, level)) {
+                Volume fill = std::min(remaining, level.volume);
+                remaining -= fill;
+                Volume left = level.volume - fill;
+                if (hitBids) orderbook.updateBid(level.price, left > 0.01 ? left : 0.0);
+                else orderbook.updateAsk(level.price, left > 0.01 ? left : 0.0);
+            }
+            break;
+        }
+    }
+
+    replenishEmptySide();
+    Price mid = orderbook.getMidPrice();
+    if (mid > 0.0) currentPrice = mid;
+    ++arrivalCounts[static_cast<int>(event.type)];
+    return event;
+}
+
+Price OrderbookSimulator::snapToTick(Price price) const {
+    return std::round(price / tickSize) * tickSize;
+}
+
+// Geometric distance from the touch (mean ~1.5 ticks), capped at the book depth
+int OrderbookSimulator::drawLevelOffset() {
+    int offset = static_cast<int>(arrivalRandom.exponential() * 2.0);
+    return std::min(offset, numLevels - 1);
+}
+
+// A side swept empty is refilled one tick away from the last mid
+void OrderbookSimulator::replenishEmptySide() {
+    Orderbook::Level level{};
+    if (!orderbook.getLevel(true, 0, level)) {
+        Price price = snapToTick(currentPrice - tickSize);
+        if (price > 0.0) orderbook.updateBid(price, 10.0 * (0.5 + arrivalRandom.uniform()));
+    }
+    if (!orderbook.getLevel(false, 0, level)) {
+        orderbook.updateAsk(snapToTick(currentPrice + tickSize), 10.0 * (0.5 + arrivalRandom.uniform()));
+    }
+}
+
+double OrderbookSimulator::randomBaseSize(int level) {
+    return 10.0 * (1.0 + 0.5 * unitDist(rng)) / (1.0 + 0.2 * level);
+}
+
+void OrderbookSimulator::setBookTime(std::chrono::time_point<std::chrono::system_clock> time, double offsetSec) {
+    orderbook.setTime(std::chrono::duration<double>(time.time_since_epoch()).count() + offsetSec);
+}
+
+void OrderbookSimulator::applyDueUpdates(std::chrono::time_point<std::chrono::system_clock> now) {
+    auto due = std::stable_partition(pendingUpdates.begin(), pendingUpdates.end(),
+                                     [now](const ScheduledUpdate& u) { return u.due > now; });
+    for (auto it = due; it != pendingUpdates.end(); ++it) {
+        if (it->isBid) {
+            orderbook.updateBid(it->price, it->volume);
+        } else {
+            orderbook.updateAsk(it->price, it->volume);
+        }
+    }
+    pendingUpdates.erase(due, pendingUpdates.end());
+}
+
+void OrderbookSimulator::writeCheckpoint(std::ostream& out) const {
+    writeBinary(out, currentPrice);
+    writeBinary(out, tickSize);
+    writeBinary(out, static_cast<int32_t>(numLevels));
+    writeBinary(out, volatility);
+
+    // Engine and normal distribution (which caches a spare variate) via their stream operators
+    std::ostringstream rngState;
+    rngState << rng << ' ' << normalDist;
+    writeString(out, rngState.str());
+
+    writeBinary(out, static_cast<uint64_t>(eventCounts.size()));
+    for (const auto& entry : eventCounts) {
+        writeString(out, entry.first);
+        writeBinary(out, static_cast<int32_t>(entry.second));
+    }
+
+    // Pending updates are stored relative to the last update so they survive a clock gap
+    writeBinary(out, static_cast<uint64_t>(pendingUpdates.size()));
+    for (const auto& update : pendingUpdates) {
+        int64_t remainingUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                update.due - lastUpdateTime).count();
+        writeBinary(out, remainingUs);
+        writeBinary(out, static_cast<uint8_t>(update.isBid));
+        writeBinary(out, update.price);
+        writeBinary(out, update.volume);
+    }
+    writeBinary(out, ticks);
+
+    // Event-driven mode: the model (with its Hawkes excitation), generator position and counts
+    writeBinary(out, static_cast<uint8_t>(arrivalModel ? 1 : 0));
+    if (arrivalModel) arrivalModel->writeCheckpoint(out);
+    arrivalRandom.writeCheckpoint(out);
+    for (uint64_t count : arrivalCounts) writeBinary(out, count);
+
+    orderbook.writeCheckpoint(out);
+}
+
+bool OrderbookSimulator::readCheckpoint(std::istream& in) {
+    // Everything is parsed into temporaries and committed once the whole block has been read
+    double price, tick, vol;
+    int32_t levels;
+    if (!readBinary(in, price) || !readBinary(in, tick) ||
+        !readBinary(in, levels) || !readBinary(in, vol)) {
+        return false;
+    }
+
+    std::string state;
+    if (!readString(in, state)) return false;
+    std::mt19937 newRng;
+    std::normal_distribution<double> newNormal;
+    std::istringstream rngState(state);
+    rngState >> newRng >> newNormal;
+    if (!rngState) return false;
+
+    uint64_t count;
+    if (!readBinary(in, count)) return false;
+    std::map<std::string, int> counts;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string name;
+        int32_t value;
+        if (!readString(in, name) || !readBinary(in, value)) return false;
+        counts[name] = value;
+    }
+
+    auto now = std::chrono::system_clock::now();
+    if (!readBinary(in, count)) return false;
+    std::vector<ScheduledUpdate> pending;
+    for (uint64_t i = 0; i < count; ++i) {
+        int64_t remainingUs;
+        uint8_t isBid;
+        ScheduledUpdate update;
+        if (!readBinary(in, remainingUs) || !readBinary(in, isBid) ||
+            !readBinary(in, update.price) || !readBinary(in, update.volume)) {
+            return false;
+        }
+        update.due = now + std::chrono::microseconds(remainingUs);
+        update.isBid = isBid != 0;
+        pending.push_back(update);
+    }
+
+    uint64_t tickCount;
+    if (!readBinary(in, tickCount)) return false;
+
+    uint8_t hasModel;
+    std::unique_ptr<ArrivalModel> model;
+    if (!readBinary(in, hasModel)) return false;
+    if (hasModel && !(model = ArrivalModel::readCheckpoint(in))) return false;
+    auto random = std::make_unique<RandomBuffer>();
+    if (!random->readCheckpoint(in)) return false;
+    std::array<uint64_t, NUM_ORDER_EVENT_TYPES> arrivals{};
+    for (uint64_t& c : arrivals) {
+        if (!readBinary(in, c)) return false;
+    }
+
+    if (!orderbook.readCheckpoint(in)) return false;    // commits only on success itself
+
+    currentPrice = price;
+    tickSize = tick;
+    numLevels = levels;
+    volatility = vol;
+    rng = newRng;
+    normalDist = newNormal;
+    eventCounts.swap(counts);
+    pendingUpdates.swap(pending);
+    ticks = tickCount;
+    arrivalModel = std::move(model);
+    arrivalRandom = *random;
+    arrivalCounts = arrivals;
+    lastUpdateTime = now;
+    arrivalEpoch = now;     // restored arrivals are stamped relative to the restore
+    setBookTime(now);
+    return true;
+}
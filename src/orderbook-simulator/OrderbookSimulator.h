@@ -13,28 +13,85 @@
  * It supports timed simulation runs and produces sequences of order book states
  * suitable for feature extraction and supervised labeling. These outputs are used
  * to train LSTM-based models for real-time financial signal detection on FPGA.
+ *
+ * Besides the tick-based generateUpdate/step path, generateEvent() drives the book
+ * one order at a time from a pluggable ArrivalModel (Poisson or Hawkes, see
+ * ArrivalModel.h), which produces the clustered bursts needed for stress tests.
+ * Its marks (level, size) come from a batched RandomBuffer. Checkpoints carry the
+ * arrival model with its process state, the buffer position and the counts, so a
+ * restored simulator continues the same arrival path; calling setArrivalModel()
+ * after restoring would reset and reseed it instead.
+ *
+ * Snapshots are stamped from the simulator's clock: a step's time (simulated
+ * for step(), the wall clock for generateUpdate() and runSimulation()) for all
+ * the changes the step makes, and the arrival time for generateEvent().
+ *
+ * Like its Orderbook (and because it owns the arrival model), a simulator is
+ * move-only.
  */
 
 
 #ifndef ORDERBOOK_ORDERBOOKSIMULATOR_H
 #define ORDERBOOK_ORDERBOOKSIMULATOR_H
 
+#include "ArrivalModel.h"
 #include "Orderbook.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <random>
 #include <chrono>
+#include <istream>
+#include <ostream>
 
 class OrderbookSimulator {
 public:
+    // Without a seed the generator is seeded from std::random_device
     OrderbookSimulator(double initialPrice = 100.0, double tickSize = 0.01,
-                       int levels = 10, double volatility = 0.001);
+                       int levels = 10, double volatility = 0.001,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+                       std::optional<uint64_t> seed = std::nullopt);
 
-    void generateUpdate();                // Generate a basic market update
+    static constexpr double DEFAULT_TICK_MS = 10.0;   // runSimulation's 100 updates per second
+
+    void generateUpdate();                // Generate a basic market update, timed by the wall clock
     void simulateRandomEvent();           // Simulate random market anomaly (large order, cancellation)
-    void runSimulation(int durationSeconds, int updatesPerSecond); // Run full simulation
+    // One tick dtMs of simulated time after the previous one: update plus a random event with given
+    // probability. Price noise and spoof reverts follow the simulated clock, so tight loops are not flat.
+    void step(double eventProbability = 0.2, double dtMs = DEFAULT_TICK_MS);
+    void runSimulation(int durationSeconds, int updatesPerSecond); // Run full simulation in real time
+
+    // Event-driven mode: one arrival from the model applied as a single book change
+    void setArrivalModel(std::unique_ptr<ArrivalModel> model);
+    ArrivalEvent generateEvent();
+    const std::array<uint64_t, NUM_ORDER_EVENT_TYPES>& getArrivalCounts() const { return arrivalCounts; }
 
     Orderbook& getOrderbook();            // Access current orderbook
+    uint64_t getTickCount() const { return ticks; }   // step()s and runSimulation ticks so far
+
+    // Checkpointing (see Checkpoint.h)
+    void writeCheckpoint(std::ostream& out) const;
+    bool readCheckpoint(std::istream& in);
 
 private:
+    // Book update deferred to a later tick (e.g. spoof removal)
+    struct ScheduledUpdate {
+        std::chrono::time_point<std::chrono::system_clock> due;
+        bool isBid;
+        Price price;
+        Volume volume;
+    };
+
+    void updateAt(std::chrono::time_point<std::chrono::system_clock> now);
+    void stepAt(std::chrono::time_point<std::chrono::system_clock> now, double eventProbability);
+    void applyDueUpdates(std::chrono::time_point<std::chrono::system_clock> now);
+    void setBookTime(std::chrono::time_point<std::chrono::system_clock> time, double offsetSec = 0.0);
+    double randomBaseSize(int level);
+    Price snapToTick(Price price) const;
+    int drawLevelOffset();
+    void replenishEmptySide();
+
     Orderbook orderbook;
     double currentPrice;
     double tickSize;
@@ -43,10 +100,18 @@ private:
 
     std::mt19937 rng;
     std::normal_distribution<double> normalDist;
+    std::uniform_real_distribution<double> unitDist;
 
-    std::chrono::time_point<std::chrono::system_clock> lastUpdateTime;
+    std::chrono::time_point<std::chrono::system_clock> lastUpdateTime;   // wall or simulated clock
+    std::chrono::time_point<std::chrono::system_clock> arrivalEpoch;     // arrival model time 0
+    uint64_t ticks = 0;
 
     std::map<std::string, int> eventCounts;
+    std::vector<ScheduledUpdate> pendingUpdates;
+
+    std::unique_ptr<ArrivalModel> arrivalModel;
+    RandomBuffer arrivalRandom;
+    std::array<uint64_t, NUM_ORDER_EVENT_TYPES> arrivalCounts{};
 
 };
 
@@ -0,0 +1,246 @@
+#include "ReplayHarness.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+uint64_t nanosBetween(Clock::time_point from, Clock::time_point to) {
+    return to > from ? std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count() : 0;
+}
+
+// Emits the updates that turn one side's previous levels into the current ones
+void diffSide(const std::pmr::vector<Orderbook::Level>& prev, const std::pmr::vector<Orderbook::Level>& curr,
+              bool isBid, std::vector<ReplayStream::LevelUpdate>& out) {
+    for (const auto& p : prev) {
+        bool kept = std::any_of(curr.begin(), curr.end(), [&](const Orderbook::Level& c) { return c.price == p.price; });
+        if (!kept) out.push_back({isBid, p.price, 0.0});
+    }
+    for (const auto& c : curr) {
+        auto it = std::find_if(prev.begin(), prev.end(), [&](const Orderbook::Level& p) { return p.price == c.price; });
+        if (it == prev.end() || it->volume != c.volume) out.push_back({isBid, c.price, c.volume});
+    }
+}
+
+} // namespace
+
+ReplayStream ReplayStream::fromHistory(const Orderbook::History& history,
+                                       const std::vector<double>* timestamps,
+                                       const std::vector<int>* messageTypes) {
+    ReplayStream stream;
+    stream.events.reserve(history.size());
+    stream.updates.reserve(history.size() * 2);
+
+    Orderbook::State empty;
+    for (size_t i = 0; i < history.size(); ++i) {
+        const Orderbook::State& prev = i > 0 ? history[i - 1] : empty;
+        const Orderbook::State& curr = history[i];
+
+        Event event{};
+        event.timestamp = timestamps && i < timestamps->size() ? (*timestamps)[i] : curr.timestamp;
+        event.messageType = messageTypes && i < messageTypes->size() ? (*messageTypes)[i] : -1;
+        event.firstUpdate = static_cast<uint32_t>(stream.updates.size());
+        diffSide(prev.bidLevels, curr.bidLevels, true, stream.updates);
+        diffSide(prev.askLevels, curr.askLevels, false, stream.updates);
+        event.numUpdates = static_cast<uint32_t>(stream.updates.size()) - event.firstUpdate;
+        stream.events.push_back(event);
+    }
+    return stream;
+}
+
+double ReplayStream::durationSeconds() const {
+    if (events.size() < 2) return 0.0;
+    return events.back().timestamp - events.front().timestamp;
+}
+
+MlpSignalPipeline::MlpSignalPipeline(const MlpWeights& weights, const FeatureScaler& scaler)
+        : window(2 * FLAT_DIM, 0.0f) {
+    FeatureScaler s = scaler;
+    if (s.mean.size() != LobFeatureStage::NUM_FEATURES) {
+        std::cerr << "Scaler has " << s.mean.size() << " features, expected "
+                  << LobFeatureStage::NUM_FEATURES << "; using identity" << std::endl;
+        s = FeatureScaler::identity(LobFeatureStage::NUM_FEATURES);
+    }
+    for (int i = 0; i < LobFeatureStage::NUM_FEATURES; ++i) {
+        mean[i] = s.mean[i];
+        scale[i] = s.scale[i];
+    }
+
+    MlpWeights w = weights;
+    if (w.layers.empty() || w.layers.front().inputs != FLAT_DIM) {
+        std::cerr << "MLP input size does not match SEQ_LEN * NUM_FEATURES; using random weights" << std::endl;
+        w = MlpWeights::random(FLAT_DIM, 64, 4);
+    }
+
+    // Store weights input-major so each input broadcasts across a contiguous
+    // row of outputs; that inner loop vectorizes without reassociating sums
+    int widest = FLAT_DIM;
+    for (size_t l = 0; l < w.layers.size(); ++l) {
+        const MlpWeights::Layer& src = w.layers[l];
+        Layer layer{src.inputs, src.outputs, l + 1 < w.layers.size(), {}, src.bias};
+        layer.weight.resize(static_cast<size_t>(src.inputs) * src.outputs);
+        for (int o = 0; o < src.outputs; ++o) {
+            for (int i = 0; i < src.inputs; ++i) {
+                layer.weight[static_cast<size_t>(i) * src.outputs + o] = src.weight[static_cast<size_t>(o) * src.inputs + i];
+            }
+        }
+        widest = std::max(widest, src.outputs);
+        layers.push_back(std::move(layer));
+    }
+    activations[0].assign(widest, 0.0f);
+    activations[1].assign(widest, 0.0f);
+}
+
+void MlpSignalPipeline::reset() {
+    featureStage.reset();
+    std::fill(window.begin(), window.end(), 0.0f);
+    windowHead = 0;
+    filled = 0;
+}
+
+int MlpSignalPipeline::onEvent(const Orderbook::State& state, int messageType) {
+    const int numFeatures = LobFeatureStage::NUM_FEATURES;
+    double features[LobFeatureStage::NUM_FEATURES];
+    featureStage.compute(state, messageType, features);
+
+    // Append at the tail of the slice and its mirror, then advance the head one timestep
+    int tail = windowHead;
+    for (int i = 0; i < numFeatures; ++i) {
+        float scaled = static_cast<float>((features[i] - mean[i]) / scale[i]);
+        window[tail + i] = scaled;
+        window[tail + FLAT_DIM + i] = scaled;
+    }
+    windowHead = (windowHead + numFeatures) % FLAT_DIM;
+    if (filled < FpgaDataflowEmulator::SEQ_LEN) ++filled;
+    if (filled < FpgaDataflowEmulator::SEQ_LEN) return -1;
+
+    const float* x = window.data() + windowHead;
+    float* y = activations[0].data();
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const Layer& layer = layers[l];
+        std::memcpy(y, layer.bias.data(), layer.outputs * sizeof(float));
+        for (int i = 0; i < layer.inputs; ++i) {
+            const float xi = x[i];
+            const float* w = layer.weight.data() + static_cast<size_t>(i) * layer.outputs;
+            for (int o = 0; o < layer.outputs; ++o) y[o] += xi * w[o];
+        }
+        if (layer.relu) {
+            for (int o = 0; o < layer.outputs; ++o) y[o] = std::max(y[o], 0.0f);
+        }
+        x = y;
+        y = activations[(l + 1) % 2].data();
+    }
+
+    const int classes = layers.back().outputs;
+    return static_cast<int>(std::max_element(x, x + classes) - x);
+}
+
+ReplayHarness::ReplayHarness(Config config) : config(config) {
+    if (this->config.speed <= 0.0) this->config.speed = 1.0;
+}
+
+bool ReplayHarness::pinToCore() const {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(config.cpuCore, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "Could not pin replay thread to core " << config.cpuCore
+                  << ": " << std::strerror(rc) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ReplayHarness::Report ReplayHarness::run(const ReplayStream& stream, SignalPipeline& pipeline) {
+    Report report;
+    report.signalCounts.assign(8, 0);
+    if (stream.events.empty()) return report;
+    if (config.cpuCore >= 0) pinToCore();
+
+    Orderbook book;
+    book.setRecordHistory(false);
+    Orderbook::State state;
+    state.bidLevels.reserve(5);
+    state.askLevels.reserve(5);
+    pipeline.reset();
+
+    const bool paced = config.pacing == Pacing::Original;
+    const double firstTimestamp = stream.events.front().timestamp;
+    const double nanosPerSecond = 1e9 / config.speed;
+    const ReplayStream::LevelUpdate* updates = stream.updates.data();
+
+    const Clock::time_point start = Clock::now();
+    for (size_t e = 0; e < stream.events.size(); ++e) {
+        const ReplayStream::Event& event = stream.events[e];
+
+        Clock::time_point due = start;
+        if (paced) {
+            auto offset = static_cast<int64_t>((event.timestamp - firstTimestamp) * nanosPerSecond);
+            due += std::chrono::nanoseconds(offset);
+            while (Clock::now() < due) cpuRelax();
+        }
+
+        const Clock::time_point dispatch = Clock::now();
+        for (uint32_t u = event.firstUpdate; u < event.firstUpdate + event.numUpdates; ++u) {
+            const ReplayStream::LevelUpdate& update = updates[u];
+            if (update.isBid) book.updateBid(update.price, update.volume);
+            else book.updateAsk(update.price, update.volume);
+        }
+        if (config.publisher) config.publisher->publish(book, event.timestamp);
+        book.getCurrentState(state);
+        int signal = pipeline.onEvent(state, event.messageType);
+        const Clock::time_point done = Clock::now();
+
+        if (e < config.warmupEvents) continue;
+        report.service.record(nanosBetween(dispatch, done));
+        report.endToEnd.record(nanosBetween(paced ? due : dispatch, done));
+        if (paced) {
+            uint64_t lag = nanosBetween(due, dispatch);
+            report.maxLagNs = std::max(report.maxLagNs, lag);
+            if (lag > 1000) ++report.lateEvents;
+        }
+        size_t slot = static_cast<size_t>(signal + 1);
+        if (slot >= report.signalCounts.size()) report.signalCounts.resize(slot + 1, 0);
+        ++report.signalCounts[slot];
+    }
+    const Clock::time_point end = Clock::now();
+
+    report.events = report.service.count();
+    report.wallSeconds = std::chrono::duration<double>(end - start).count();
+    report.eventsPerSecond = report.wallSeconds > 0.0 ? stream.events.size() / report.wallSeconds : 0.0;
+    return report;
+}
+
+void ReplayHarness::printReport(const Report& report, std::ostream& out) {
+    out << "\n--- Replay Report ---" << std::endl;
+    out << "Events recorded: " << report.events << std::endl;
+    out << "Wall time:       " << std::fixed << std::setprecision(3) << report.wallSeconds << " s ("
+        << std::setprecision(0) << report.eventsPerSecond << " events/s)" << std::endl;
+    out << "Late (>1us):     " << report.lateEvents << "  max lag " << report.maxLagNs << " ns" << std::endl;
+    report.service.print(out, "service");
+    report.endToEnd.print(out, "end-to-end");
+
+    out << "Signals:        ";
+    for (size_t i = 0; i < report.signalCounts.size(); ++i) {
+        if (report.signalCounts[i] == 0) continue;
+        out << " [" << static_cast<int>(i) - 1 << "]=" << report.signalCounts[i];
+    }
+    out << std::endl;
+    out.unsetf(std::ios::fixed);
+    out << std::setprecision(6);
+}
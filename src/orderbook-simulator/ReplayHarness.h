@@ -0,0 +1,141 @@
+/*
+ * File: ReplayHarness.h
+ *
+ * Description:
+ * Rate-controlled replay of recorded or simulated book events through the
+ * software signal path (book -> features -> classifier), measuring per-event
+ * tick-to-signal latency.
+ *
+ * A ReplayStream is a flat list of level updates grouped into events, built by
+ * diffing consecutive top-of-book snapshots (a LOBSTER day or simulator
+ * history), so replaying it rebuilds exactly the recorded depth. The harness
+ * busy-spins until each event's due time (original timestamps, scaled by a
+ * speed factor, or back-to-back), applies its updates to an Orderbook with
+ * history recording off, and calls the SignalPipeline. Two histograms are
+ * kept per run:
+ *
+ *   - service:    dispatch -> signal, the cost of the software path alone
+ *   - end-to-end: scheduled arrival -> signal, which adds queueing when a
+ *                 burst arrives faster than the path can drain it
+ *
+ * The replay thread can be pinned to a core so the numbers are comparable to
+ * the FPGA emulator's cycle-accurate latencies on the same stream. With a
+ * SharedBookPublisher attached, each event's book is also published to shared
+ * memory before the pipeline runs, and that cost is part of the service time.
+ */
+
+#ifndef ORDERBOOK_REPLAYHARNESS_H
+#define ORDERBOOK_REPLAYHARNESS_H
+
+#include "FpgaDataflowEmulator.h"
+#include "LatencyHistogram.h"
+#include "Orderbook.h"
+#include "SharedBook.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+struct ReplayStream {
+    struct LevelUpdate {
+        bool isBid;
+        Price price;
+        Volume volume;      // 0 removes the level
+    };
+
+    struct Event {
+        double timestamp;   // seconds
+        int messageType;    // LOBSTER type, -1 if unknown
+        uint32_t firstUpdate;
+        uint32_t numUpdates;
+    };
+
+    std::vector<Event> events;
+    std::vector<LevelUpdate> updates;
+
+    // One event per snapshot; timestamps/messageTypes override the snapshot's own when given
+    static ReplayStream fromHistory(const Orderbook::History& history,
+                                    const std::vector<double>* timestamps = nullptr,
+                                    const std::vector<int>* messageTypes = nullptr);
+
+    double durationSeconds() const;
+};
+
+// Work done per event after the book update; returns the emitted signal
+class SignalPipeline {
+public:
+    virtual ~SignalPipeline() = default;
+    virtual void reset() = 0;
+    virtual int onEvent(const Orderbook::State& state, int messageType) = 0;
+};
+
+// The deployed model in software float: LobFeatureStage -> scale -> SEQ_LEN window -> MLP -> argmax.
+// Allocation-free per event; returns -1 until the window has filled.
+class MlpSignalPipeline : public SignalPipeline {
+public:
+    MlpSignalPipeline(const MlpWeights& weights, const FeatureScaler& scaler);
+
+    void reset() override;
+    int onEvent(const Orderbook::State& state, int messageType) override;
+
+private:
+    static constexpr int FLAT_DIM = FpgaDataflowEmulator::SEQ_LEN * LobFeatureStage::NUM_FEATURES;
+
+    struct Layer {
+        int inputs;
+        int outputs;
+        bool relu;
+        std::vector<float> weight;
+        std::vector<float> bias;
+    };
+
+    LobFeatureStage featureStage;
+    std::vector<Layer> layers;
+    double mean[LobFeatureStage::NUM_FEATURES];
+    double scale[LobFeatureStage::NUM_FEATURES];
+
+    // Each timestep is written twice, FLAT_DIM apart, so the current window is
+    // always the contiguous slice starting at windowHead
+    std::vector<float> window;
+    int windowHead = 0;
+    int filled = 0;
+    std::vector<float> activations[2];
+};
+
+class ReplayHarness {
+public:
+    enum class Pacing {
+        Original,       // original inter-arrival times, divided by speed
+        FlatOut         // back-to-back, no waiting
+    };
+
+    struct Config {
+        Pacing pacing = Pacing::Original;
+        double speed = 1.0;         // > 1 replays faster than recorded
+        int cpuCore = -1;           // pin the replay thread; -1 leaves affinity alone
+        size_t warmupEvents = 0;    // run but do not record the first events
+        SharedBookPublisher* publisher = nullptr;   // optional, not owned
+    };
+
+    struct Report {
+        uint64_t events = 0;
+        double wallSeconds = 0.0;
+        double eventsPerSecond = 0.0;
+        uint64_t lateEvents = 0;        // dispatched more than 1 us after their due time
+        uint64_t maxLagNs = 0;
+        LatencyHistogram service;
+        LatencyHistogram endToEnd;
+        std::vector<uint64_t> signalCounts;     // index = signal + 1 (so -1 lands in 0)
+    };
+
+    explicit ReplayHarness(Config config);
+
+    Report run(const ReplayStream& stream, SignalPipeline& pipeline);
+    static void printReport(const Report& report, std::ostream& out);
+
+private:
+    bool pinToCore() const;
+
+    Config config;
+};
+
+#endif // ORDERBOOK_REPLAYHARNESS_H
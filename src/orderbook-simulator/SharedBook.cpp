@@ -0,0 +1,257 @@
+#include "SharedBook.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+uint32_t roundUpPowerOfTwo(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n && p < (1u << 30)) p <<= 1;
+    return p;
+}
+
+size_t segmentBytesFor(uint32_t ringCapacity) {
+    return sizeof(SharedBookSegment) + static_cast<size_t>(ringCapacity) * sizeof(SharedDeltaSlot);
+}
+
+// Top `depth` levels of one side into a fixed array; returns the count
+int readSide(const Orderbook& book, bool isBid, int depth, Orderbook::Level* out) {
+    int count = 0;
+    while (count < depth && book.getLevel(isBid, count, out[count])) ++count;
+    return count;
+}
+
+} // namespace
+
+SharedBookPublisher::~SharedBookPublisher() {
+    close();
+}
+
+bool SharedBookPublisher::open(const std::string& segmentName, int depth, uint32_t ringCapacity) {
+    close();
+    depth = std::max(1, std::min(depth, SHARED_BOOK_MAX_LEVELS));
+    ringCapacity = roundUpPowerOfTwo(std::max(ringCapacity, 64u));
+    size_t bytes = segmentBytesFor(ringCapacity);
+
+    // Replace any stale segment so readers never attach to a half-sized one
+    shm_unlink(segmentName.c_str());
+    int fd = shm_open(segmentName.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+    if (fd < 0) {
+        std::cerr << "shm_open(" << segmentName << ") failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        std::cerr << "Could not size shared book segment: " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(segmentName.c_str());
+        return false;
+    }
+    void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Could not map shared book segment: " << std::strerror(errno) << std::endl;
+        shm_unlink(segmentName.c_str());
+        return false;
+    }
+
+    // The fresh segment is zero-filled, which is also a valid state for every sequence
+    segment = new (addr) SharedBookSegment();
+    ring = reinterpret_cast<SharedDeltaSlot*>(static_cast<char*>(addr) + sizeof(SharedBookSegment));
+    for (uint32_t i = 0; i < ringCapacity; ++i) new (&ring[i]) SharedDeltaSlot();
+
+    segment->version = SHARED_BOOK_VERSION;
+    segment->depth = static_cast<uint32_t>(depth);
+    segment->ringCapacity = ringCapacity;
+    segment->segmentBytes = bytes;
+    segment->snapshotSequence.store(0, std::memory_order_relaxed);
+    segment->deltaHead.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment->magic = SHARED_BOOK_MAGIC;
+
+    name = segmentName;
+    mappedBytes = bytes;
+    updateCount = 0;
+    deltaCount = 0;
+    lastBidCount = 0;
+    lastAskCount = 0;
+    return true;
+}
+
+void SharedBookPublisher::close() {
+    if (!segment) return;
+    munmap(segment, mappedBytes);
+    shm_unlink(name.c_str());
+    segment = nullptr;
+    ring = nullptr;
+    mappedBytes = 0;
+}
+
+void SharedBookPublisher::publish(const Orderbook& book, double timestamp) {
+    if (!segment) return;
+    const int depth = static_cast<int>(segment->depth);
+
+    Orderbook::Level bids[SHARED_BOOK_MAX_LEVELS];
+    Orderbook::Level asks[SHARED_BOOK_MAX_LEVELS];
+    int bidCount = readSide(book, true, depth, bids);
+    int askCount = readSide(book, false, depth, asks);
+    ++updateCount;
+
+    // Seqlock write: odd while the snapshot is inconsistent
+    uint64_t sequence = segment->snapshotSequence.load(std::memory_order_relaxed);
+    segment->snapshotSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SharedBookSnapshot& snapshot = segment->snapshot;
+    snapshot.updateCount = updateCount;
+    snapshot.timestamp = timestamp;
+    snapshot.midPrice = book.getMidPrice();
+    snapshot.spread = book.getSpread();
+    snapshot.bidCount = static_cast<uint32_t>(bidCount);
+    snapshot.askCount = static_cast<uint32_t>(askCount);
+    std::memcpy(snapshot.bids, bids, sizeof(Orderbook::Level) * bidCount);
+    std::memcpy(snapshot.asks, asks, sizeof(Orderbook::Level) * askCount);
+
+    segment->snapshotSequence.store(sequence + 2, std::memory_order_release);
+
+    // Deltas against the previous view, published after the snapshot they lead to
+    auto diff = [&](bool isBid, const Orderbook::Level* prev, int prevCount,
+                    const Orderbook::Level* curr, int currCount) {
+        for (int p = 0; p < prevCount; ++p) {
+            bool kept = false;
+            for (int c = 0; c < currCount && !kept; ++c) kept = curr[c].price == prev[p].price;
+            if (!kept) appendDelta(isBid, prev[p].price, 0.0, timestamp);
+        }
+        for (int c = 0; c < currCount; ++c) {
+            bool same = false;
+            for (int p = 0; p < prevCount && !same; ++p) {
+                same = prev[p].price == curr[c].price && prev[p].volume == curr[c].volume;
+            }
+            if (!same) appendDelta(isBid, curr[c].price, curr[c].volume, timestamp);
+        }
+    };
+    diff(true, lastBids, lastBidCount, bids, bidCount);
+    diff(false, lastAsks, lastAskCount, asks, askCount);
+    segment->deltaHead.store(deltaCount, std::memory_order_release);
+
+    std::memcpy(lastBids, bids, sizeof(Orderbook::Level) * bidCount);
+    std::memcpy(lastAsks, asks, sizeof(Orderbook::Level) * askCount);
+    lastBidCount = bidCount;
+    lastAskCount = askCount;
+}
+
+void SharedBookPublisher::appendDelta(bool isBid, Price price, Volume volume, double timestamp) {
+    uint64_t index = deltaCount++;
+    SharedDeltaSlot& slot = ring[index & (segment->ringCapacity - 1)];
+
+    // 0 marks the slot as being rewritten so a lagging reader detects the lap
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.delta = {updateCount, timestamp, price, volume, static_cast<uint8_t>(isBid)};
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+SharedBookReader::~SharedBookReader() {
+    close();
+}
+
+bool SharedBookReader::open(const std::string& segmentName) {
+    close();
+    int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "shm_open(" << segmentName << ") failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedBookSegment)) {
+        std::cerr << "Shared book segment " << segmentName << " is too small" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Could not map shared book segment: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const auto* header = static_cast<const SharedBookSegment*>(addr);
+    bool valid = header->magic == SHARED_BOOK_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || header->version != SHARED_BOOK_VERSION || header->segmentBytes != bytes ||
+        segmentBytesFor(header->ringCapacity) != bytes) {
+        std::cerr << "Segment " << segmentName << " is not a version " << SHARED_BOOK_VERSION
+                  << " shared book" << std::endl;
+        munmap(addr, bytes);
+        return false;
+    }
+
+    segment = header;
+    ring = reinterpret_cast<const SharedDeltaSlot*>(static_cast<const char*>(addr) + sizeof(SharedBookSegment));
+    mappedBytes = bytes;
+    seekToLatest();
+    return true;
+}
+
+void SharedBookReader::close() {
+    if (!segment) return;
+    munmap(const_cast<SharedBookSegment*>(segment), mappedBytes);
+    segment = nullptr;
+    ring = nullptr;
+    mappedBytes = 0;
+}
+
+bool SharedBookReader::readSnapshot(SharedBookSnapshot& out) const {
+    if (!segment) return false;
+    while (true) {
+        uint64_t before = segment->snapshotSequence.load(std::memory_order_acquire);
+        if (before == 0) return false;
+        if (before & 1) continue;
+        std::memcpy(&out, &segment->snapshot, sizeof(SharedBookSnapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment->snapshotSequence.load(std::memory_order_relaxed) == before) return true;
+    }
+}
+
+size_t SharedBookReader::pollDeltas(SharedLevelDelta* out, size_t maxDeltas, bool& overrun) {
+    overrun = false;
+    if (!segment) return 0;
+    const uint64_t capacity = segment->ringCapacity;
+    const uint64_t head = segment->deltaHead.load(std::memory_order_acquire);
+    if (head - cursor > capacity) {
+        overrun = true;
+        cursor = head;
+        return 0;
+    }
+
+    size_t count = 0;
+    while (cursor < head && count < maxDeltas) {
+        const SharedDeltaSlot& slot = ring[cursor & (capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != cursor + 1) break;
+        SharedLevelDelta delta;
+        std::memcpy(&delta, &slot.delta, sizeof(SharedLevelDelta));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != cursor + 1) break;
+        out[count++] = delta;
+        ++cursor;
+    }
+    // A slot that no longer holds our index was overwritten by a newer lap
+    if (cursor < head && count < maxDeltas) {
+        overrun = true;
+        cursor = segment->deltaHead.load(std::memory_order_acquire);
+    }
+    return count;
+}
+
+// Resync point: take the head before reading the snapshot, then skip deltas
+// whose updateCount the snapshot already includes
+void SharedBookReader::seekToLatest() {
+    if (segment) cursor = segment->deltaHead.load(std::memory_order_acquire);
+}
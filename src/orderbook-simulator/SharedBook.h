@@ -0,0 +1,138 @@
+/*
+ * File: SharedBook.h
+ *
+ * Description:
+ * Publishes the top-N levels of one Orderbook into a POSIX shared-memory
+ * segment so feature, inference and monitoring processes can watch the same
+ * book without running their own simulator or replay.
+ *
+ * Segment layout (fixed, trivially copyable, one writer):
+ *
+ *   SharedBookSegment   header (magic, version, depth, ring capacity)
+ *                       snapshot under a seqlock: top of book + N levels
+ *                       deltaHead: number of deltas ever written
+ *   DeltaSlot[capacity] broadcast ring of level deltas, each stamped with its
+ *                       own sequence number
+ *
+ * Snapshot seqlock: the writer bumps the sequence to odd, writes, then bumps
+ * it back to even. A reader copies the snapshot between two loads of the
+ * sequence and retries if they differ or are odd, so reads never block the
+ * writer and never go through the kernel.
+ *
+ * Delta ring: every publish() diffs the new top-N view against the previous
+ * one and appends one delta per changed level (volume 0 = level left the
+ * view). Readers keep their own cursor. A reader that falls more than one
+ * ring behind is told it overran and should resync from the snapshot.
+ */
+
+#ifndef ORDERBOOK_SHAREDBOOK_H
+#define ORDERBOOK_SHAREDBOOK_H
+
+#include "Orderbook.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+constexpr uint32_t SHARED_BOOK_MAGIC = 0x4853424F;     // "OBSH"
+constexpr uint32_t SHARED_BOOK_VERSION = 1;
+constexpr int SHARED_BOOK_MAX_LEVELS = 10;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory sequences must be lock-free");
+
+struct SharedBookSnapshot {
+    uint64_t updateCount;       // publishes so far
+    double timestamp;
+    Price midPrice;
+    Price spread;
+    uint32_t bidCount;
+    uint32_t askCount;
+    Orderbook::Level bids[SHARED_BOOK_MAX_LEVELS];
+    Orderbook::Level asks[SHARED_BOOK_MAX_LEVELS];
+};
+
+struct SharedLevelDelta {
+    uint64_t updateCount;       // publish that produced this delta
+    double timestamp;
+    Price price;
+    Volume volume;              // 0 = level removed from the top-N view
+    uint8_t isBid;
+};
+
+struct SharedBookSegment {
+    uint32_t magic;             // written last by the publisher
+    uint32_t version;
+    uint32_t depth;
+    uint32_t ringCapacity;      // power of two
+    uint64_t segmentBytes;
+
+    alignas(64) std::atomic<uint64_t> snapshotSequence;
+    SharedBookSnapshot snapshot;
+
+    alignas(64) std::atomic<uint64_t> deltaHead;
+};
+
+struct alignas(64) SharedDeltaSlot {
+    std::atomic<uint64_t> sequence;     // index + 1 once written, 0 while being rewritten
+    SharedLevelDelta delta;
+};
+
+class SharedBookPublisher {
+public:
+    SharedBookPublisher() = default;
+    ~SharedBookPublisher();
+    SharedBookPublisher(const SharedBookPublisher&) = delete;
+    SharedBookPublisher& operator=(const SharedBookPublisher&) = delete;
+
+    // name is a shm_open name such as "/orderbook"; an existing segment is replaced
+    bool open(const std::string& name, int depth = 5, uint32_t ringCapacity = 1u << 16);
+    void close();       // unmaps and unlinks
+    bool isOpen() const { return segment != nullptr; }
+
+    void publish(const Orderbook& book, double timestamp);
+
+private:
+    void appendDelta(bool isBid, Price price, Volume volume, double timestamp);
+
+    std::string name;
+    SharedBookSegment* segment = nullptr;
+    SharedDeltaSlot* ring = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t updateCount = 0;
+    uint64_t deltaCount = 0;
+
+    // Last published view, to diff against
+    Orderbook::Level lastBids[SHARED_BOOK_MAX_LEVELS] = {};
+    Orderbook::Level lastAsks[SHARED_BOOK_MAX_LEVELS] = {};
+    int lastBidCount = 0;
+    int lastAskCount = 0;
+};
+
+class SharedBookReader {
+public:
+    SharedBookReader() = default;
+    ~SharedBookReader();
+    SharedBookReader(const SharedBookReader&) = delete;
+    SharedBookReader& operator=(const SharedBookReader&) = delete;
+
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return segment != nullptr; }
+    int depth() const { return segment ? static_cast<int>(segment->depth) : 0; }
+
+    // Consistent copy of the latest snapshot; false if none was published yet
+    bool readSnapshot(SharedBookSnapshot& out) const;
+
+    // Copies up to maxDeltas unread deltas. overrun is set (and the cursor
+    // moves to the head) when the writer lapped this reader.
+    size_t pollDeltas(SharedLevelDelta* out, size_t maxDeltas, bool& overrun);
+    void seekToLatest();
+
+private:
+    const SharedBookSegment* segment = nullptr;
+    const SharedDeltaSlot* ring = nullptr;
+    size_t mappedBytes = 0;
+    uint64_t cursor = 0;
+};
+
+#endif // ORDERBOOK_SHAREDBOOK_H
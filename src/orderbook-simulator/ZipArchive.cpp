@@ -0,0 +1,186 @@
+#include "ZipArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+
+constexpr uint32_t LOCAL_HEADER_SIG = 0x04034b50;
+constexpr uint32_t CENTRAL_HEADER_SIG = 0x02014b50;
+constexpr uint32_t END_OF_CENTRAL_DIR_SIG = 0x06054b50;
+constexpr size_t END_OF_CENTRAL_DIR_SIZE = 22;
+constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+uint16_t read16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t read32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // namespace
+
+ZipArchive::ZipArchive(const std::string& path) : path(path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open zip archive: " << path << std::endl;
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data = static_cast<const unsigned char*>(p);
+            size = st.st_size;
+        }
+    }
+    close(fd);
+
+    if (!data) {
+        std::cerr << "Failed to map zip archive: " << path << std::endl;
+        return;
+    }
+
+    if (!readCentralDirectory()) {
+        std::cerr << "Malformed or unsupported zip archive: " << path << std::endl;
+        munmap(const_cast<unsigned char*>(data), size);
+        data = nullptr;
+        size = 0;
+        members.clear();
+    }
+}
+
+ZipArchive::~ZipArchive() {
+    if (data) munmap(const_cast<unsigned char*>(data), size);
+}
+
+bool ZipArchive::readCentralDirectory() {
+    if (size < END_OF_CENTRAL_DIR_SIZE) return false;
+
+    // The end-of-central-directory record sits at the end, before an optional comment
+    size_t searchStart = size > END_OF_CENTRAL_DIR_SIZE + MAX_COMMENT_SIZE
+                         ? size - END_OF_CENTRAL_DIR_SIZE - MAX_COMMENT_SIZE : 0;
+    const unsigned char* eocd = nullptr;
+    for (size_t pos = size - END_OF_CENTRAL_DIR_SIZE + 1; pos-- > searchStart;) {
+        if (read32(data + pos) == END_OF_CENTRAL_DIR_SIG) {
+            eocd = data + pos;
+            break;
+        }
+    }
+    if (!eocd) return false;
+
+    uint16_t entryCount = read16(eocd + 10);
+    uint32_t directoryOffset = read32(eocd + 16);
+
+    size_t pos = directoryOffset;
+    members.reserve(entryCount);
+    for (uint16_t i = 0; i < entryCount; ++i) {
+        if (pos + 46 > size || read32(data + pos) != CENTRAL_HEADER_SIG) return false;
+        const unsigned char* h = data + pos;
+
+        Member member;
+        member.method = read16(h + 10);
+        member.crc32 = read32(h + 16);
+        member.compressedSize = read32(h + 20);
+        member.uncompressedSize = read32(h + 24);
+        uint16_t nameLength = read16(h + 28);
+        uint16_t extraLength = read16(h + 30);
+        uint16_t commentLength = read16(h + 32);
+        member.localHeaderOffset = read32(h + 42);
+
+        if (pos + 46 + nameLength > size) return false;
+        member.name.assign(reinterpret_cast<const char*>(h + 46), nameLength);
+        members.push_back(std::move(member));
+
+        pos += 46 + nameLength + extraLength + commentLength;
+    }
+
+    return true;
+}
+
+const ZipArchive::Member* ZipArchive::find(const std::string& fragment, const std::string& suffix) const {
+    for (const auto& member : members) {
+        const std::string& name = member.name;
+        if (name.find(fragment) == std::string::npos) continue;
+        if (name.size() < suffix.size() ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+            continue;
+        }
+        return &member;
+    }
+    return nullptr;
+}
+
+bool ZipArchive::extract(const Member& member, std::string& out) const {
+    size_t pos = member.localHeaderOffset;
+    if (!data || pos + 30 > size || read32(data + pos) != LOCAL_HEADER_SIG) {
+        std::cerr << "Bad local header for " << member.name << " in " << path << std::endl;
+        return false;
+    }
+
+    size_t dataOffset = pos + 30 + read16(data + pos + 26) + read16(data + pos + 28);
+    if (dataOffset + member.compressedSize > size) {
+        std::cerr << "Truncated member " << member.name << " in " << path << std::endl;
+        return false;
+    }
+    const unsigned char* compressed = data + dataOffset;
+
+    // A stored member is copied verbatim, so both sizes must describe the same bytes
+    if (member.method == 0 && member.compressedSize != member.uncompressedSize) {
+        std::cerr << "Stored member " << member.name << " has mismatched sizes in " << path << std::endl;
+        return false;
+    }
+
+    out.resize(member.uncompressedSize);
+
+    if (member.method == 0) {
+        std::memcpy(&out[0], compressed, member.uncompressedSize);
+    } else if (member.method == 8) {
+        // Raw deflate stream (negative window bits: no zlib header)
+        z_stream stream{};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) return false;
+
+        stream.next_in = const_cast<Bytef*>(compressed);
+        stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        uint64_t inLeft = member.compressedSize;
+        uint64_t outLeft = member.uncompressedSize;
+        int status = Z_OK;
+        while (status == Z_OK) {
+            if (stream.avail_in == 0) {
+                stream.avail_in = static_cast<uInt>(std::min<uint64_t>(inLeft, UINT32_MAX));
+                inLeft -= stream.avail_in;
+            }
+            if (stream.avail_out == 0) {
+                stream.avail_out = static_cast<uInt>(std::min<uint64_t>(outLeft, UINT32_MAX));
+                outLeft -= stream.avail_out;
+            }
+            status = inflate(&stream, Z_NO_FLUSH);
+        }
+        inflateEnd(&stream);
+
+        if (status != Z_STREAM_END || stream.total_out != member.uncompressedSize) {
+            std::cerr << "Inflate failed for " << member.name << " in " << path << std::endl;
+            return false;
+        }
+    } else {
+        std::cerr << "Unsupported compression method " << member.method
+                  << " for " << member.name << " in " << path << std::endl;
+        return false;
+    }
+
+    uLong crc = crc32_z(0L, reinterpret_cast<const Bytef*>(out.data()), out.size());
+    if (crc != member.crc32) {
+        std::cerr << "CRC mismatch for " << member.name << " in " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
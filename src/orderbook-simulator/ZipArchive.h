@@ -0,0 +1,58 @@
+/*
+ * File: ZipArchive.h
+ *
+ * Description:
+ * Read-only access to the members of a .zip archive, enough to pull LOBSTER
+ * message/orderbook CSVs straight out of data/raw without unpacking to disk.
+ *
+ * The archive is memory-mapped and member sizes are taken from the central
+ * directory (LOBSTER archives set the data-descriptor flag, so local headers
+ * carry zero sizes). Stored (0) and deflated (8) members are supported; ZIP64
+ * and encrypted archives are not.
+ */
+
+#ifndef ORDERBOOK_ZIPARCHIVE_H
+#define ORDERBOOK_ZIPARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ZipArchive {
+public:
+    struct Member {
+        std::string name;
+        uint16_t method;
+        uint32_t crc32;
+        uint64_t compressedSize;
+        uint64_t uncompressedSize;
+        uint64_t localHeaderOffset;
+    };
+
+    explicit ZipArchive(const std::string& path);
+    ~ZipArchive();
+
+    ZipArchive(const ZipArchive&) = delete;
+    ZipArchive& operator=(const ZipArchive&) = delete;
+
+    bool isOpen() const { return data != nullptr; }
+    const std::string& getPath() const { return path; }
+    const std::vector<Member>& getMembers() const { return members; }
+
+    // First member whose name contains `fragment` and ends with `suffix`, or nullptr
+    const Member* find(const std::string& fragment, const std::string& suffix = "") const;
+
+    // Decompress a member into `out`; thread-safe (the mapping is read-only). A deflate
+    // stream decodes front to back, so one member inflates serially on the calling thread.
+    bool extract(const Member& member, std::string& out) const;
+
+private:
+    bool readCentralDirectory();
+
+    std::string path;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    std::vector<Member> members;
+};
+
+#endif // ORDERBOOK_ZIPARCHIVE_H
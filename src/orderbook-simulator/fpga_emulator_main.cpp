@@ -0,0 +1,148 @@
+/*
+ * File: fpga_emulator_main.cpp
+ *
+ * Description:
+ * Replays a LOBSTER archive or a synthetic simulator stream through the
+ * FpgaDataflowEmulator and prints throughput/latency/bottleneck estimates.
+ *
+ * Usage:
+ *   fpga_emulator [options]
+ *     --lobster <zip>        replay a LOBSTER_SampleFile_*.zip (message timestamps)
+ *     --sim <ticks>          replay a synthetic stream (default, 2000 ticks)
+ *     --rate <events/s>      synthetic stream arrival rate        (default 1e6)
+ *     --weights <file>       MLPW weights (src/hls/export_emulator_params.py)
+ *     --scaler <file>        SCLR feature scaler                   (default identity)
+ *     --clock <MHz>          fabric clock                          (default 200)
+ *     --fixed <W>,<I>        ap_fixed format of the MLP            (default 16,6)
+ *     --feature-fixed <W>,<I>   ap_fixed format of computed features (default 48,16)
+ *     --price-fixed <W>,<I>  ap_fixed format of input prices       (default 48,20)
+ *     --size-fixed <W>,<I>   ap_fixed format of input sizes        (default 48,32)
+ *     --double-features      feed the MLP from double features (isolates MLP error)
+ *     --fifo <depth>         inter-stage FIFO depth                (default 2)
+ *     --stage <name>:<ii>:<latency>   override one stage (repeatable)
+ *     --saturate             feed back-to-back, ignore timestamps
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "FpgaDataflowEmulator.h"
+#include "LobsterIngest.h"
+#include "OrderbookSimulator.h"
+#include "ThreadPool.h"
+
+static bool parseFormat(const std::string& spec, FixedPointFormat& format) {
+    size_t comma = spec.find(',');
+    if (comma == std::string::npos) return false;
+    format.width = std::atoi(spec.substr(0, comma).c_str());
+    format.integerBits = std::atoi(spec.substr(comma + 1).c_str());
+    return format.width > 1 && format.width <= 63 && format.integerBits >= 1 && format.integerBits <= format.width;
+}
+
+static bool parseStage(const std::string& spec, StageTiming& stage) {
+    size_t a = spec.find(':');
+    size_t b = spec.find(':', a + 1);
+    if (a == std::string::npos || b == std::string::npos) return false;
+    stage.name = spec.substr(0, a);
+    stage.initiationInterval = std::atoi(spec.substr(a + 1, b - a - 1).c_str());
+    stage.latency = std::atoi(spec.substr(b + 1).c_str());
+    return stage.initiationInterval > 0 && stage.latency >= 0;
+}
+
+int main(int argc, char** argv) {
+    std::string lobsterPath, weightsPath, scalerPath;
+    int simTicks = 2000;
+    double rate = 1e6;
+    FpgaDataflowEmulator::Config config;
+    std::vector<StageTiming> overrides;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--lobster" && hasValue) lobsterPath = argv[++i];
+        else if (arg == "--sim" && hasValue) simTicks = std::atoi(argv[++i]);
+        else if (arg == "--rate" && hasValue) rate = std::atof(argv[++i]);
+        else if (arg == "--weights" && hasValue) weightsPath = argv[++i];
+        else if (arg == "--scaler" && hasValue) scalerPath = argv[++i];
+        else if (arg == "--clock" && hasValue) config.clockMHz = std::atof(argv[++i]);
+        else if (arg == "--fifo" && hasValue) config.fifoDepth = std::atoi(argv[++i]);
+        else if (arg == "--saturate") config.saturate = true;
+        else if (arg == "--double-features") config.fixedFeatures = false;
+        else if ((arg == "--feature-fixed" || arg == "--price-fixed" || arg == "--size-fixed") && hasValue) {
+            FeatureFormats& ports = config.featureFormats;
+            FixedPointFormat& format = arg == "--feature-fixed" ? ports.feature
+                                     : arg == "--price-fixed" ? ports.price : ports.size;
+            if (!parseFormat(argv[++i], format)) {
+                std::cerr << "Bad " << arg << " spec (want W,I with 1 <= I <= W <= 63): " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--fixed" && hasValue) {
+            std::string spec = argv[++i];
+            size_t comma = spec.find(',');
+            config.format.width = std::atoi(spec.substr(0, comma).c_str());
+            config.format.integerBits = comma == std::string::npos ? 6 : std::atoi(spec.substr(comma + 1).c_str());
+        } else if (arg == "--stage" && hasValue) {
+            StageTiming stage;
+            if (!parseStage(argv[++i], stage)) {
+                std::cerr << "Bad --stage spec (want name:ii:latency): " << argv[i] << std::endl;
+                return 1;
+            }
+            overrides.push_back(stage);
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    MlpWeights weights;
+    if (weightsPath.empty()) {
+        std::cout << "Using random weights (timing is independent of weight values)" << std::endl;
+        weights = MlpWeights::random(MODEL_FLAT_DIM, 64, 4);
+    } else if (!weights.load(weightsPath, MODEL_FLAT_DIM)) {
+        return 1;
+    }
+    FeatureScaler scaler = FeatureScaler::identity(LobFeatureStage::NUM_FEATURES);
+    if (!scalerPath.empty() && !scaler.load(scalerPath, LobFeatureStage::NUM_FEATURES)) return 1;
+
+    config.stages = FpgaDataflowEmulator::defaultStages(weights);
+    for (const auto& o : overrides) {
+        bool found = false;
+        for (auto& stage : config.stages) {
+            if (stage.name == o.name) {
+                stage = o;
+                found = true;
+            }
+        }
+        if (!found) {
+            std::cerr << "No stage named " << o.name << std::endl;
+            return 1;
+        }
+    }
+
+    FpgaDataflowEmulator emulator(config, weights, scaler);
+
+    if (!lobsterPath.empty()) {
+        ThreadPool pool(2);
+        auto days = ingestLobsterArchives({lobsterPath}, pool);
+        if (days.empty() || !days[0].ok) return 1;
+        const LobsterDay& day = days[0];
+        auto history = day.toHistory();
+        std::cout << "Replaying " << history.size() << " LOBSTER events from " << lobsterPath << std::endl;
+        for (size_t i = 0; i < history.size(); ++i) {
+            emulator.push(history[i], day.messages.time[i], day.messages.type[i]);
+        }
+    } else {
+        OrderbookSimulator simulator(100.0, 0.05, 10, 0.2);
+        for (int i = 0; i < simTicks; ++i) simulator.step();
+        const auto& history = simulator.getOrderbook().getHistory();
+        std::cout << "Replaying " << history.size() << " simulator events at " << rate << " events/s" << std::endl;
+        for (size_t i = 0; i < history.size(); ++i) {
+            emulator.push(history[i], i / rate);
+        }
+    }
+
+    emulator.printReport(std::cout);
+    return 0;
+}
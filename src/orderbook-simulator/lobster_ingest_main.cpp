@@ -0,0 +1,64 @@
+/*
+ * File: lobster_ingest_main.cpp
+ *
+ * Description:
+ * Command-line bulk ingest of LOBSTER sample archives. Reads every
+ * LOBSTER_SampleFile_*.zip in the input directory in parallel and writes one
+ * columnar .bin per archive (see LobsterDay::saveColumns for the layout).
+ *
+ * Usage:
+ *   lobster_ingest [data_dir] [out_dir] [levels] [threads]
+ *     data_dir  directory with the zip archives   (default ../../data/raw)
+ *     out_dir   where <SYMBOL>_<DATE>_<LEVELS>.bin files go (default .)
+ *     levels    only archives with this depth, 0 = all       (default 0)
+ *     threads   worker threads, 0 = hardware concurrency     (default 0)
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "LobsterIngest.h"
+#include "ThreadPool.h"
+
+int main(int argc, char** argv) {
+    std::string dataDir = argc > 1 ? argv[1] : "../../data/raw";
+    std::string outDir = argc > 2 ? argv[2] : ".";
+    int levels = argc > 3 ? std::atoi(argv[3]) : 0;
+    size_t threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+
+    auto paths = findLobsterArchives(dataDir, levels);
+    if (paths.empty()) {
+        std::cerr << "No LOBSTER archives found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    ThreadPool pool(threads ? threads : std::thread::hardware_concurrency());
+    std::cout << "Ingesting " << paths.size() << " archives on " << pool.size() << " threads..." << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    auto days = ingestLobsterArchives(paths, pool);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int failures = 0;
+    size_t totalRows = 0;
+    for (const auto& day : days) {
+        if (!day.ok) {
+            ++failures;
+            continue;
+        }
+        std::string outPath = outDir + "/" + day.symbol + "_" + day.date + "_" +
+                              std::to_string(day.levels) + ".bin";
+        if (!day.saveColumns(outPath)) {
+            ++failures;
+            continue;
+        }
+        totalRows += day.messages.rows();
+        std::cout << "  " << day.symbol << " " << day.date << " L" << day.levels << ": "
+                  << day.messages.rows() << " rows -> " << outPath << std::endl;
+    }
+
+    std::cout << "Parsed " << totalRows << " rows in " << seconds << "s ("
+              << (seconds > 0 ? totalRows / seconds : 0.0) << " rows/s)" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
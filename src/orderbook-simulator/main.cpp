@@ -14,11 +14,22 @@
  * of directional price moves in high-frequency trading environments.
  *
  * Main Tasks:
- *  - Run a 10-second order book simulation and save the output to CSV
- *  - Run a 30-second simulation, extract features, assign labels, and save .bin files
+ *  - Run a 10-second order book simulation, streaming its history to CSV
+ *  - Run a 30-second simulation, sample it into one bar per update interval, extract
+ *    and standardize the deployed feature set (FeatureRegistry.h), assign labels, and
+ *    stream the .bin files (MODEL_FLAT_DIM values per sequence)
+ *  - Save the fitted scaler as feature_scaler.sclr (13 columns, for --scaler)
+ *
+ * Resumable generation (instead of the tasks above):
+ *   orderbook --chunks <n> [--ticks-per-chunk <m>] [--checkpoint <file>] [--resume]
+ * generates n chunks of m simulated ticks (default 100000), each streamed to
+ * orderbook_chunk_<k>.csv, and checkpoints the simulator after every chunk
+ * (default orderbook.ckpt). --resume restores the checkpoint and continues
+ * with the first chunk it does not cover.
  */
 
 
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -27,6 +38,10 @@
 #include "Orderbook.h"
 #include "OrderbookSimulator.h"
 #include "FeatureExtraction.h"
+#include "BarSampler.h"
+#include "Checkpoint.h"
+#include "MemoryArena.h"
+#include "ThreadPool.h"
 
 // Utility function to print timestamp
 std::string getTimeString() {
@@ -38,45 +53,120 @@ std::string getTimeString() {
 }
 
 // Test orderbook simulation and saving to CSV
-void testOrderbookSimulation() {
+bool testOrderbookSimulation() {
     std::cout << "[" << getTimeString() << "] Starting orderbook simulation test..." << std::endl;
 
     OrderbookSimulator simulator(100.0, 0.05, 10, 0.2);
-    simulator.runSimulation(10, 100);  // 10 seconds, 100 updates per second
     Orderbook& orderbook = simulator.getOrderbook();
     std::string csvFilename = "orderbook_simulation.csv";
-    orderbook.saveHistoryToCSV(csvFilename);
+    if (!orderbook.streamHistoryToCSV(csvFilename)) return false;  // rows go to disk while the simulation runs
+    simulator.runSimulation(10, 100);  // 10 seconds, 100 updates per second
+    if (!orderbook.finishHistoryStream()) return false;
     std::cout << "[" << getTimeString() << "] Saved orderbook history to " << csvFilename << std::endl;
+    return true;
 }
 
 // Test full feature extraction pipeline
-void testFeatureExtraction() {
+bool testFeatureExtraction() {
     std::cout << "[" << getTimeString() << "] Starting feature extraction test..." << std::endl;
 
-    OrderbookSimulator simulator(100.0, 0.05, 10, 0.2);  // volatility = 0.005
-    simulator.runSimulation(30, 100);  // 30 seconds, 100 updates per second
+    // ~20 level updates per tick plus random events; the arena must outlive the simulator
+    const size_t expectedEvents = 30 * 100 * 24;
+    MemoryArena arena(MemoryArena::bytesForEvents(expectedEvents));
+
+    OrderbookSimulator simulator(100.0, 0.05, 10, 0.2, &arena);  // volatility = 0.005
+    simulator.getOrderbook().reserveHistory(expectedEvents);
+    const int updatesPerSecond = 100;
+    simulator.runSimulation(30, updatesPerSecond);  // 30 seconds
 
     Orderbook& orderbook = simulator.getOrderbook();
-    const auto& states = orderbook.getHistory();  // <-- add getHistory() method if not defined yet
 
-    FeatureExtractor extractor(10, 100.0);
-    auto features = extractor.extractFeatures(states);
+    // Time bars of one update interval: a step records a variable number of snapshots (its
+    // level updates, random events and due spoof reverts), so count-based bars drift
+    // against the steps. The simulator stamps all of a step's snapshots with the step's
+    // time, so a bar closes on the book as it stood after the last step in its interval.
+    // runSimulation paces steps by the wall clock, so an interval can catch no step or
+    // two, and there are somewhat fewer bars than steps.
+    BarSampler sampler({BarSampler::Type::Time, 1.0 / updatesPerSecond});
+    auto bars = sampler.sample(orderbook.getHistory());
+    auto states = BarSampler::closingStates(bars, &arena);
+    std::cout << "Sampled " << orderbook.getHistory().size() << " snapshots into "
+              << bars.size() << " time bars" << std::endl;
+
+    // Training rows are the deployed model's 13 columns, MODEL_SEQ_LEN bars per sequence
+    // (MODEL_FLAT_DIM values). The scaler is fitted during extraction, standardizes the
+    // rows as they are written, and is what fpga_emulator / backtest --scaler load.
+    FeatureNormalizer normalizer(DeployedFeatureSet::WIDTH);
+    FeatureExtractor extractor(10, 100.0, &arena);
+    extractor.setNormalizer(&normalizer);
+    extractor.setDebugOutput(true);
+    ThreadPool pool;
+    auto rows = extractor.extractDeployedFeatures(states);
+    normalizer.freeze();
 
     // Collect midPrices for labeling
     std::vector<double> midPrices;
-    for (const auto& state : states) {
-        midPrices.push_back(state.midPrice);
+    for (const auto& bar : bars) {
+        midPrices.push_back(bar.close);
     }
 
-    extractor.prepareLabeledData(features, midPrices, 10, 0.000001);
-    std::cout << "Created " << features.size() << " sequences with labels" << std::endl;
+    if (!extractor.streamToFiles("features.bin", "labels.bin")) return false;
+    extractor.prepareLabeledData(rows, midPrices, pool, 0.000001);
     extractor.printLabelStats();  // You can add this helper to count class distribution
-    extractor.saveToFiles("features.bin", "labels.bin");
+    return extractor.finishStream() && normalizer.saveScaler("feature_scaler.sclr");
+}
+
+// Chunked generation that survives restarts: the checkpoint written after each
+// chunk records the simulator's tick count, which says where to pick up
+bool generateChunks(int chunks, uint64_t ticksPerChunk, const std::string& checkpointPath, bool resume) {
+    OrderbookSimulator simulator(100.0, 0.05, 10, 0.2);
+    Orderbook& orderbook = simulator.getOrderbook();
+    orderbook.setRecordHistory(false);  // chunks go straight to disk
+
+    if (resume) {
+        if (!loadCheckpoint(checkpointPath, simulator)) return false;
+        std::cout << "[" << getTimeString() << "] Resuming from " << checkpointPath << " after "
+                  << simulator.getTickCount() << " ticks" << std::endl;
+    }
+
+    for (uint64_t chunk = simulator.getTickCount() / ticksPerChunk; chunk < static_cast<uint64_t>(chunks); ++chunk) {
+        std::string csvFilename = "orderbook_chunk_" + std::to_string(chunk) + ".csv";
+        if (!orderbook.streamHistoryToCSV(csvFilename)) return false;
+        while (simulator.getTickCount() < (chunk + 1) * ticksPerChunk) simulator.step();
+        if (!orderbook.finishHistoryStream() || !saveCheckpoint(checkpointPath, simulator)) return false;
+        std::cout << "[" << getTimeString() << "] Chunk " << chunk << " written to " << csvFilename
+                  << ", checkpoint " << checkpointPath << std::endl;
+    }
+    return true;
 }
 
 // Main entry point
-int main() {
-    testOrderbookSimulation();
-    testFeatureExtraction();
-    return 0;
+int main(int argc, char** argv) {
+    int chunks = 0;
+    uint64_t ticksPerChunk = 100000;
+    std::string checkpointPath = "orderbook.ckpt";
+    bool resume = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--chunks" && hasValue) chunks = std::atoi(argv[++i]);
+        else if (arg == "--ticks-per-chunk" && hasValue) ticksPerChunk = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--checkpoint" && hasValue) checkpointPath = argv[++i];
+        else if (arg == "--resume") resume = true;
+        else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (chunks > 0) {
+        if (ticksPerChunk == 0) {
+            std::cerr << "--ticks-per-chunk must be positive" << std::endl;
+            return 1;
+        }
+        return generateChunks(chunks, ticksPerChunk, checkpointPath, resume) ? 0 : 1;
+    }
+
+    return testOrderbookSimulation() && testFeatureExtraction() ? 0 : 1;
 }
@@ -0,0 +1,105 @@
+/*
+ * File: orderbook_c.h
+ *
+ * Description:
+ * Stable C ABI over the Orderbook / OrderbookSimulator / FeatureExtractor
+ * classes, built as the liborderbook_c shared library. It is meant to be
+ * loaded from Python with ctypes (see src/data/native_orderbook.py) so the
+ * training pipeline can generate, extract and label data in-process instead
+ * of going through CSV and .bin files on disk.
+ *
+ * Results are exposed as ob_buffer descriptors (pointer, shape, dtype) over
+ * C-contiguous memory owned by the library, which numpy can wrap without a copy.
+ * Buffer lifetimes:
+ *   - ob_array buffers live until ob_array_destroy().
+ *   - ob_extractor_sequences/labels buffers live until the next
+ *     ob_extractor_label() call on that extractor or ob_extractor_destroy().
+ *
+ * All functions are exception-safe and reject NULL handles: failures return NULL,
+ * a negative value or 0.0 (mid price, spread), and ob_last_error() describes the
+ * most recent failure on the calling thread.
+ * OB_ABI_VERSION is bumped on any incompatible change.
+ */
+
+#ifndef ORDERBOOK_ORDERBOOK_C_H
+#define ORDERBOOK_ORDERBOOK_C_H
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define OB_API __declspec(dllexport)
+#else
+#define OB_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OB_ABI_VERSION 2
+
+typedef struct ob_book ob_book;
+typedef struct ob_simulator ob_simulator;
+typedef struct ob_extractor ob_extractor;
+typedef struct ob_array ob_array;
+
+typedef enum {
+    OB_DTYPE_FLOAT64 = 0,
+    OB_DTYPE_INT32 = 1
+} ob_dtype;
+
+/* C-contiguous view: ndim is 1 or 2, shape[1] is 1 for vectors */
+typedef struct {
+    void* data;
+    int64_t shape[2];
+    int32_t ndim;
+    int32_t dtype;
+} ob_buffer;
+
+OB_API int32_t ob_abi_version(void);
+OB_API const char* ob_last_error(void);
+
+/* Order book */
+OB_API ob_book* ob_book_create(void);
+OB_API void ob_book_destroy(ob_book* book);
+OB_API void ob_book_update_bid(ob_book* book, double price, double volume);
+OB_API void ob_book_update_ask(ob_book* book, double price, double volume);
+OB_API void ob_book_clear_level(ob_book* book, int32_t is_bid, double price);
+/* Apply n updates in order; is_bid[i] selects the side, volume <= 0 removes the level */
+OB_API int32_t ob_book_apply_updates(ob_book* book, const int8_t* is_bid, const double* prices,
+                                     const double* volumes, int64_t n);
+OB_API double ob_book_mid_price(const ob_book* book);
+OB_API double ob_book_spread(const ob_book* book);
+OB_API int64_t ob_book_history_size(const ob_book* book);
+/* History as [n x 27] float64, columns as in Orderbook::saveHistoryToCSV */
+OB_API ob_array* ob_book_history(const ob_book* book);
+
+/* Simulator; the book returned by ob_simulator_book is owned by the simulator. Equal
+   seeds give the same prices and volumes; snapshot timestamps start at creation time. */
+OB_API ob_simulator* ob_simulator_create(double initial_price, double tick_size,
+                                         int32_t levels, double volatility, uint64_t seed);
+OB_API void ob_simulator_destroy(ob_simulator* simulator);
+/* Each tick advances the simulator's clock by a fixed 10 ms (OrderbookSimulator::DEFAULT_TICK_MS) */
+OB_API int32_t ob_simulator_step(ob_simulator* simulator, int64_t ticks, double event_probability);
+OB_API ob_book* ob_simulator_book(ob_simulator* simulator);
+
+/* Feature extraction and labeling */
+OB_API ob_extractor* ob_extractor_create(int32_t price_feature_window, double volume_normalization);
+OB_API void ob_extractor_destroy(ob_extractor* extractor);
+/* Features of every state in the book's history, from empty windows, as [n x 32] float64 */
+OB_API ob_array* ob_extractor_extract(ob_extractor* extractor, const ob_book* book);
+/* Label the most recent extraction; returns the number of sequences, or -1 (and empty
+   sequences/labels) if it has no more than sequence_length + 5 states */
+OB_API int64_t ob_extractor_label(ob_extractor* extractor, int32_t sequence_length, double threshold);
+OB_API ob_buffer ob_extractor_sequences(const ob_extractor* extractor);
+OB_API ob_buffer ob_extractor_labels(const ob_extractor* extractor);
+
+/* Library-owned result arrays */
+OB_API ob_buffer ob_array_buffer(const ob_array* array);
+OB_API void ob_array_destroy(ob_array* array);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ORDERBOOK_ORDERBOOK_C_H */
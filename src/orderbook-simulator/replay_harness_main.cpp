@@ -0,0 +1,153 @@
+/*
+ * File: replay_harness_main.cpp
+ *
+ * Description:
+ * Replays a LOBSTER archive or a synthetic simulator stream through the
+ * software book -> features -> MLP path at a controlled rate and prints
+ * tick-to-signal latency histograms (see ReplayHarness.h).
+ *
+ * Usage:
+ *   replay_harness [options]
+ *     --lobster <zip>        replay a LOBSTER_SampleFile_*.zip at its message timestamps
+ *     --sim <ticks>          replay a synthetic stream (default, 2000 ticks)
+ *     --rate <events/s>      synthetic mean arrival rate             (default 1e5)
+ *     --arrivals <model>     synthetic order flow: ticks (step(), exponential gaps),
+ *                            poisson or hawkes (generateEvent())    (default ticks)
+ *     --speed <x>            replay x times faster than recorded      (default 1)
+ *     --flat-out             ignore timestamps, replay back-to-back
+ *     --core <n>             pin the replay thread to core n
+ *     --warmup <n>           events excluded from the histograms      (default 1000)
+ *     --weights <file>       MLPW weights (src/hls/export_emulator_params.py)
+ *     --scaler <file>        SCLR feature scaler                     (default identity)
+ *     --histogram <file>     write the end-to-end histogram as CSV
+ *     --publish <name>       publish the book to shared memory (watch with shared_book_monitor)
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include "LobsterIngest.h"
+#include "OrderbookSimulator.h"
+#include "ReplayHarness.h"
+#include "ThreadPool.h"
+
+int main(int argc, char** argv) {
+    std::string lobsterPath, weightsPath, scalerPath, histogramPath, publishName, arrivals = "ticks";
+    int simTicks = 2000;
+    double rate = 1e5;
+    ReplayHarness::Config config;
+    config.warmupEvents = 1000;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--lobster" && hasValue) lobsterPath = argv[++i];
+        else if (arg == "--sim" && hasValue) simTicks = std::atoi(argv[++i]);
+        else if (arg == "--rate" && hasValue) rate = std::atof(argv[++i]);
+        else if (arg == "--arrivals" && hasValue) arrivals = argv[++i];
+        else if (arg == "--speed" && hasValue) config.speed = std::atof(argv[++i]);
+        else if (arg == "--flat-out") config.pacing = ReplayHarness::Pacing::FlatOut;
+        else if (arg == "--core" && hasValue) config.cpuCore = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && hasValue) config.warmupEvents = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--weights" && hasValue) weightsPath = argv[++i];
+        else if (arg == "--scaler" && hasValue) scalerPath = argv[++i];
+        else if (arg == "--histogram" && hasValue) histogramPath = argv[++i];
+        else if (arg == "--publish" && hasValue) publishName = argv[++i];
+        else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    MlpWeights weights;
+    if (weightsPath.empty()) {
+        std::cout << "Using random weights (latency is independent of weight values)" << std::endl;
+        weights = MlpWeights::random(MODEL_FLAT_DIM, 64, 4);
+    } else if (!weights.load(weightsPath, MODEL_FLAT_DIM)) {
+        return 1;
+    }
+    FeatureScaler scaler = FeatureScaler::identity(LobFeatureStage::NUM_FEATURES);
+    if (!scalerPath.empty() && !scaler.load(scalerPath, LobFeatureStage::NUM_FEATURES)) return 1;
+
+    ReplayStream stream;
+    if (!lobsterPath.empty()) {
+        ThreadPool pool(2);
+        auto days = ingestLobsterArchives({lobsterPath}, pool);
+        if (days.empty() || !days[0].ok) return 1;
+        const LobsterDay& day = days[0];
+        stream = ReplayStream::fromHistory(day.toHistory(), &day.messages.time, &day.messages.type);
+        std::cout << "Replaying " << stream.events.size() << " LOBSTER events ("
+                  << stream.updates.size() << " level updates) from " << lobsterPath << std::endl;
+    } else if (arrivals == "poisson" || arrivals == "hawkes") {
+        OrderbookSimulator simulator(100.0, 0.01, 10, 0.2);
+        if (arrivals == "hawkes") {
+            simulator.setArrivalModel(std::make_unique<HawkesArrivalModel>(HawkesArrivalModel::withMeanRate(rate)));
+        } else {
+            ArrivalModel::Rates rates;
+            rates.fill(rate / NUM_ORDER_EVENT_TYPES);
+            simulator.setArrivalModel(std::make_unique<PoissonArrivalModel>(rates));
+        }
+
+        // Seeded levels replay at t=0; every snapshot an arrival produces (a
+        // market order can clear several levels) carries that arrival's time
+        const auto& history = simulator.getOrderbook().getHistory();
+        std::vector<double> times(history.size(), 0.0);
+        for (int i = 0; i < simTicks; ++i) {
+            double time = simulator.generateEvent().time;
+            times.resize(history.size(), time);
+        }
+        stream = ReplayStream::fromHistory(history, &times);
+        std::cout << "Replaying " << stream.events.size() << " " << arrivals << " arrivals at ~"
+                  << rate << " events/s" << std::endl;
+    } else {
+        OrderbookSimulator simulator(100.0, 0.05, 10, 0.2);
+        for (int i = 0; i < simTicks; ++i) simulator.step();
+        const auto& history = simulator.getOrderbook().getHistory();
+
+        // Exponential inter-arrivals give the bursts a fixed-interval stream lacks
+        std::mt19937_64 rng(7);
+        std::exponential_distribution<double> gap(rate);
+        std::vector<double> times(history.size());
+        double t = 0.0;
+        for (auto& time : times) {
+            time = t;
+            t += gap(rng);
+        }
+        stream = ReplayStream::fromHistory(history, &times);
+        std::cout << "Replaying " << stream.events.size() << " simulator events at ~"
+                  << rate << " events/s" << std::endl;
+    }
+
+    if (config.pacing == ReplayHarness::Pacing::Original) {
+        std::cout << "Pacing: recorded timestamps x" << config.speed << " ("
+                  << stream.durationSeconds() / config.speed << " s)" << std::endl;
+    } else {
+        std::cout << "Pacing: flat out" << std::endl;
+    }
+
+    SharedBookPublisher publisher;
+    if (!publishName.empty()) {
+        if (!publisher.open(publishName)) return 1;
+        config.publisher = &publisher;
+        std::cout << "Publishing book to shared memory segment " << publishName << std::endl;
+    }
+
+    MlpSignalPipeline pipeline(weights, scaler);
+    ReplayHarness harness(config);
+    ReplayHarness::Report report = harness.run(stream, pipeline);
+    ReplayHarness::printReport(report, std::cout);
+
+    if (!histogramPath.empty()) {
+        std::ofstream out(histogramPath);
+        if (!out) {
+            std::cerr << "Could not open " << histogramPath << std::endl;
+            return 1;
+        }
+        report.endToEnd.writeCsv(out);
+        std::cout << "End-to-end histogram written to " << histogramPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * File: shared_book_monitor.cpp
+ *
+ * Description:
+ * Attaches to a book published with SharedBookPublisher (e.g. replay_harness
+ * --publish /orderbook) and prints, once per second, the latest top of book,
+ * the delta rate, ring overruns and the cost of a snapshot read.
+ *
+ * Usage:
+ *   shared_book_monitor [name] [seconds]      (defaults: /orderbook, 10)
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SharedBook.h"
+
+int main(int argc, char** argv) {
+    std::string name = argc > 1 ? argv[1] : "/orderbook";
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    SharedBookReader reader;
+    for (int attempt = 0; attempt < 50 && !reader.open(name); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (!reader.isOpen()) return 1;
+    std::cout << "Attached to " << name << " (depth " << reader.depth() << ")" << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<SharedLevelDelta> deltas(4096);
+    SharedBookSnapshot snapshot{};
+    uint64_t totalDeltas = 0;
+    uint64_t overruns = 0;
+
+    auto end = Clock::now() + std::chrono::seconds(seconds);
+    while (Clock::now() < end) {
+        auto intervalEnd = Clock::now() + std::chrono::seconds(1);
+        uint64_t intervalDeltas = 0;
+        uint64_t reads = 0;
+        double readNanos = 0.0;
+
+        while (Clock::now() < intervalEnd) {
+            bool overrun = false;
+            size_t n = reader.pollDeltas(deltas.data(), deltas.size(), overrun);
+            intervalDeltas += n;
+            if (overrun) ++overruns;
+
+            auto t0 = Clock::now();
+            bool haveSnapshot = reader.readSnapshot(snapshot);
+            auto t1 = Clock::now();
+            if (haveSnapshot) {
+                readNanos += std::chrono::duration<double, std::nano>(t1 - t0).count();
+                ++reads;
+            }
+        }
+        totalDeltas += intervalDeltas;
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "update " << snapshot.updateCount
+                  << "  bid " << (snapshot.bidCount ? snapshot.bids[0].price : 0.0)
+                  << " x " << (snapshot.bidCount ? snapshot.bids[0].volume : 0.0)
+                  << "  ask " << (snapshot.askCount ? snapshot.asks[0].price : 0.0)
+                  << " x " << (snapshot.askCount ? snapshot.asks[0].volume : 0.0)
+                  << "  deltas/s " << intervalDeltas
+                  << "  overruns " << overruns
+                  << "  snapshot read " << std::setprecision(1) << (reads ? readNanos / reads : 0.0) << " ns"
+                  << std::endl;
+    }
+
+    std::cout << "Consumed " << totalDeltas << " deltas" << std::endl;
+    return 0;
+}
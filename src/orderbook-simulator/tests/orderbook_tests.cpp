@@ -0,0 +1,284 @@
+/*
+ * File: orderbook_tests.cpp
+ *
+ * Description:
+ * Regression checks for the pipeline pieces whose output has to be exact:
+ * checkpoint save/load, the SCLR scaler format, the normalizer's Welford/Chan
+ * merge, FixedPointFormat rounding and saturation, and parallel vs sequential
+ * feature extraction. Run through CTest; every check prints what failed and the
+ * process exits non-zero if any did.
+ */
+
+#include "Checkpoint.h"
+#include "FeatureExtraction.h"
+#include "FeatureNormalizer.h"
+#include "FixedPoint.h"
+#include "OrderbookSimulator.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" \
+                      << std::endl;                                                   \
+            ++failures;                                                               \
+        }                                                                             \
+    } while (0)
+
+std::string tempPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() /
+            ("orderbook_tests_" + std::to_string(::getpid()) + "_" + name)).string();
+}
+
+bool sameFeatures(const std::vector<OrderbookFeature>& a, const std::vector<OrderbookFeature>& b) {
+    if (a.size() != b.size()) return false;
+    double x[OrderbookFeature::DIMENSION];
+    double y[OrderbookFeature::DIMENSION];
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i].writeTo(x);
+        b[i].writeTo(y);
+        for (int j = 0; j < OrderbookFeature::DIMENSION; ++j) {
+            // Bitwise, except that NaN equals NaN
+            if (x[j] != y[j] && !(std::isnan(x[j]) && std::isnan(y[j]))) return false;
+        }
+    }
+    return true;
+}
+
+bool sameLevels(Orderbook& a, Orderbook& b) {
+    auto bidsA = a.getBidLevels(100), bidsB = b.getBidLevels(100);
+    auto asksA = a.getAskLevels(100), asksB = b.getAskLevels(100);
+    if (bidsA.size() != bidsB.size() || asksA.size() != asksB.size()) return false;
+    for (size_t i = 0; i < bidsA.size(); ++i) {
+        if (bidsA[i].price != bidsB[i].price || bidsA[i].volume != bidsB[i].volume) return false;
+    }
+    for (size_t i = 0; i < asksA.size(); ++i) {
+        if (asksA[i].price != asksB[i].price || asksA[i].volume != asksB[i].volume) return false;
+    }
+    return true;
+}
+
+// States recorded since `from`, as their own history
+Orderbook::History tail(const Orderbook::History& history, size_t from) {
+    return Orderbook::History(history.begin() + static_cast<std::ptrdiff_t>(from), history.end());
+}
+
+void testCheckpointRoundTrip() {
+    const std::string path = tempPath("checkpoint.bin");
+
+    OrderbookSimulator original(100.0, 0.01, 10, 0.001, std::pmr::get_default_resource(), 7);
+    FeatureExtractor originalExtractor;
+    for (int i = 0; i < 200; ++i) original.step();
+    originalExtractor.extractFeatures(original.getOrderbook().getHistory());
+    original.setArrivalModel(std::make_unique<HawkesArrivalModel>(HawkesArrivalModel::withMeanRate(500.0)));
+    for (int i = 0; i < 100; ++i) original.generateEvent();
+    size_t savedStates = original.getOrderbook().getHistory().size();
+    CHECK(saveCheckpoint(path, original, &originalExtractor));
+
+    // Different seed and cold windows: everything that matters has to come from the file
+    OrderbookSimulator restored(50.0, 0.05, 5, 0.01, std::pmr::get_default_resource(), 99);
+    FeatureExtractor restoredExtractor;
+    CHECK(loadCheckpoint(path, restored, &restoredExtractor));
+    CHECK(sameLevels(original.getOrderbook(), restored.getOrderbook()));
+    CHECK(original.getTickCount() == restored.getTickCount());
+    size_t restoredStates = restored.getOrderbook().getHistory().size();
+
+    for (int i = 0; i < 300; ++i) {
+        ArrivalEvent a = original.generateEvent();
+        ArrivalEvent b = restored.generateEvent();
+        CHECK(a.type == b.type);
+    }
+    for (int i = 0; i < 200; ++i) {
+        original.step();
+        restored.step();
+    }
+    CHECK(sameLevels(original.getOrderbook(), restored.getOrderbook()));
+    CHECK(original.getArrivalCounts() == restored.getArrivalCounts());
+
+    // Restored windows continue the series exactly where the saved ones stopped
+    auto expected = originalExtractor.extractFeatures(tail(original.getOrderbook().getHistory(), savedStates));
+    auto actual = restoredExtractor.extractFeatures(tail(restored.getOrderbook().getHistory(), restoredStates));
+    CHECK(!expected.empty());
+    CHECK(sameFeatures(expected, actual));
+
+    // A corrupt file is rejected and leaves the target untouched
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "OBCK garbage";
+    }
+    OrderbookSimulator untouched(100.0, 0.01, 10, 0.001, std::pmr::get_default_resource(), 7);
+    for (int i = 0; i < 10; ++i) untouched.step();
+    uint64_t ticks = untouched.getTickCount();
+    CHECK(!loadCheckpoint(path, untouched));
+    CHECK(untouched.getTickCount() == ticks);
+
+    std::remove(path.c_str());
+}
+
+void testScalerFormat() {
+    const std::string path = tempPath("scaler.bin");
+    std::vector<double> mean = {0.0, -1.5, 3.25e-7, 1e12};
+    std::vector<double> scale = {1.0, 0.5, 2.0e-3, 7.0};
+    CHECK(FeatureNormalizer::writeScaler(path, mean, scale));
+
+    std::vector<double> readMean, readScale;
+    CHECK(FeatureNormalizer::readScaler(path, readMean, readScale));
+    CHECK(readMean == mean);
+    CHECK(readScale == scale);
+
+    // Layout: "SCLR" | uint32 n | float64 mean[n] | float64 scale[n]
+    CHECK(std::filesystem::file_size(path) == 4 + 4 + 2 * mean.size() * sizeof(double));
+
+    FeatureNormalizer matching(mean.size());
+    CHECK(matching.loadScaler(path));
+    CHECK(matching.isFrozen());
+    CHECK(matching.getMean() == mean);
+    FeatureNormalizer mismatched(mean.size() + 1);
+    CHECK(!mismatched.loadScaler(path));
+
+    // Truncated files are rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    CHECK(!FeatureNormalizer::readScaler(path, readMean, readScale));
+
+    // Mismatched lengths are not written
+    CHECK(!FeatureNormalizer::writeScaler(path, mean, std::vector<double>(1, 1.0)));
+
+    std::remove(path.c_str());
+}
+
+void testNormalizerMerge() {
+    const size_t dimension = 3;
+    const size_t rows = 10000;
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<double> data(rows * dimension);
+    for (size_t i = 0; i < rows; ++i) {
+        data[i * dimension + 0] = 1e6 + noise(rng);          // large offset, unit spread
+        data[i * dimension + 1] = 1e-3 * noise(rng);
+        data[i * dimension + 2] = 4.0;                       // constant
+    }
+
+    FeatureNormalizer sequential(dimension);
+    for (size_t i = 0; i < rows; ++i) sequential.observe(&data[i * dimension]);
+
+    // Uneven shards, including an empty one, merged in order
+    const size_t bounds[] = {0, 1, 1, 3000, 7777, rows};
+    FeatureNormalizer merged(dimension);
+    for (size_t s = 0; s + 1 < std::size(bounds); ++s) {
+        FeatureNormalizer shard(dimension);
+        for (size_t i = bounds[s]; i < bounds[s + 1]; ++i) shard.observe(&data[i * dimension]);
+        merged.merge(shard);
+    }
+
+    sequential.freeze();
+    merged.freeze();
+    for (size_t j = 0; j < dimension; ++j) {
+        CHECK(merged.count(j) == rows);
+        CHECK(std::fabs(merged.getMean()[j] - sequential.getMean()[j]) <=
+              1e-12 * std::max(1.0, std::fabs(sequential.getMean()[j])));
+        CHECK(std::fabs(merged.getScale()[j] - sequential.getScale()[j]) <= 1e-9 * sequential.getScale()[j]);
+    }
+    CHECK(std::fabs(sequential.getScale()[0] - 1.0) < 0.05);
+    CHECK(sequential.getScale()[2] == 1.0);                  // constant feature passes through unscaled
+
+    // Non-finite inputs are skipped while fitting
+    FeatureNormalizer withNan(1);
+    double values[] = {1.0, std::nan(""), 3.0, INFINITY};
+    for (double& v : values) withNan.observe(&v);
+    withNan.freeze();
+    CHECK(withNan.count(0) == 2);
+    CHECK(withNan.getMean()[0] == 2.0);
+}
+
+void testFixedPoint() {
+    FixedPointFormat f{16, 6};     // ap_fixed<16,6>: 10 fractional bits
+    CHECK(f.fractionalBits() == 10);
+    CHECK(f.maxRaw() == 32767);
+    CHECK(f.minRaw() == -32768);
+
+    // AP_TRN: floor towards -infinity
+    CHECK(f.quantize(1.0) == 1024);
+    CHECK(f.quantize(1.0 + 0.9 * f.resolution()) == 1024);
+    CHECK(f.quantize(-1e-6) == -1);
+    CHECK(f.quantize(-1.0 - 0.1 * f.resolution()) == -1025);
+    CHECK(f.toDouble(f.quantize(-2.5)) == -2.5);
+
+    // AP_SAT at both ends; NaN maps to 0
+    CHECK(f.quantize(32.0) == f.maxRaw());
+    CHECK(f.quantize(1e300) == f.maxRaw());
+    CHECK(f.quantize(-32.0) == f.minRaw());
+    CHECK(f.quantize(-INFINITY) == f.minRaw());
+    CHECK(f.quantize(std::nan("")) == 0);
+    CHECK(f.toDouble(f.maxRaw()) == 32.0 - f.resolution());
+
+    // Requantizing a product accumulator (20 fractional bits) floors, then saturates
+    CHECK(f.fromWide(int64_t(3) << 20, 20) == 3 << 10);
+    CHECK(f.fromWide(1023, 20) == 0);
+    CHECK(f.fromWide(-1, 20) == -1);
+    CHECK(f.fromWide(int64_t(1) << 40, 20) == f.maxRaw());
+    CHECK(f.fromWide(-(int64_t(1) << 40), 20) == f.minRaw());
+    // Fewer fractional bits than the target widen exactly
+    CHECK(f.fromWide(-3, 8) == -12);
+}
+
+void testParallelExtraction() {
+    OrderbookSimulator simulator(100.0, 0.01, 10, 0.001, std::pmr::get_default_resource(), 11);
+    for (int i = 0; i < 1500; ++i) simulator.step();
+    const Orderbook::History& history = simulator.getOrderbook().getHistory();
+    CHECK(history.size() > 4 * 4096);    // enough states for several parallel chunks
+
+    FeatureExtractor sequentialExtractor;
+    auto sequential = sequentialExtractor.extractFeatures(history);
+
+    ThreadPool pool(4);
+    FeatureExtractor parallelExtractor;
+    auto parallel = parallelExtractor.extractFeatures(history, pool);
+    CHECK(sequential.size() == history.size());
+    CHECK(sameFeatures(sequential, parallel));
+
+    // Split calls carry the windows across, in both modes
+    size_t half = history.size() / 2 + 17;
+    FeatureExtractor splitExtractor;
+    auto first = splitExtractor.extractFeatures(
+            Orderbook::History(history.begin(), history.begin() + static_cast<std::ptrdiff_t>(half)));
+    auto second = splitExtractor.extractFeatures(tail(history, half), pool);
+    first.insert(first.end(), second.begin(), second.end());
+    CHECK(sameFeatures(sequential, first));
+
+    // resetWindows() starts a new series
+    splitExtractor.resetWindows();
+    FeatureExtractor fresh;
+    CHECK(sameFeatures(splitExtractor.extractFeatures(tail(history, half)),
+                       fresh.extractFeatures(tail(history, half))));
+}
+
+} // namespace
+
+int main() {
+    testCheckpointRoundTrip();
+    testScalerFormat();
+    testNormalizerMerge();
+    testFixedPoint();
+    testParallelExtraction();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}